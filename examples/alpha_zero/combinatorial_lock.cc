@@ -105,6 +105,7 @@ int main(int argc, char **argv)
             .self_play_workers_(6)
             .training_batchsize_(64)
             .training_mcts_steps_(8 * length)
+            .reanalyse_fraction_(1.0f)
             .training_dirchlet_noise_alpha_(0.5)
             .training_dirchlet_noise_epsilon_(0.25)
             .training_temperature_control_(temperature_control)
@@ -3,6 +3,7 @@
 
 
 #include "mcts.h"
+#include "evaluation_cache.h"
 #include "trainer.h"
 #include "self_play_episode.h"
 
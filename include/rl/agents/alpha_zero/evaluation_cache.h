@@ -0,0 +1,86 @@
+#ifndef RL_AGENTS_ALPHA_ZERO_EVALUATION_CACHE_H_
+#define RL_AGENTS_ALPHA_ZERO_EVALUATION_CACHE_H_
+
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+
+#include <torch/torch.h>
+
+#include <rl/option.h>
+#include <rl/logging/client/base.h>
+
+#include "mcts.h"
+
+
+namespace rl::agents::alpha_zero
+{
+    struct EvaluationCacheOptions
+    {
+        // Maximum number of cached states. Least recently used states are evicted
+        // first.
+        RL_OPTION(size_t, max_size) = 100000;
+
+        RL_OPTION(std::shared_ptr<rl::logging::client::Base>, logger) = nullptr;
+        // Number of looked up states over which the logged hit rate is computed.
+        RL_OPTION(int64_t, log_interval) = 10000;
+    };
+
+    /**
+     * @brief Bounded LRU cache of network evaluations, keyed by the dtype, shape and
+     * bytes of each state. Thread safe, and may be shared between several searches.
+     */
+    class EvaluationCache
+    {
+        public:
+            EvaluationCache(const EvaluationCacheOptions &options={});
+
+            /**
+             * @brief Evaluates a batch of states, only forwarding cache misses to the
+             * inference function.
+             * 
+             * @param states Batch of states, shape (N, *).
+             * @param inference_fn Inference function, called with states on
+             * `module_device`.
+             * @param module_device Device on which inference is executed.
+             * @return MCTSInferenceResult Priors and values, located on the CPU.
+             */
+            MCTSInferenceResult evaluate(
+                const torch::Tensor &states,
+                const std::function<MCTSInferenceResult(const torch::Tensor &)> &inference_fn,
+                torch::Device module_device
+            );
+
+            /**
+             * @brief Signals that new parameters are in use, invalidating all cached
+             * evaluations.
+             */
+            void publish_version();
+
+            size_t size();
+
+        private:
+            struct Entry
+            {
+                std::string key;
+                torch::Tensor prior;
+                float value;
+            };
+
+            const EvaluationCacheOptions options;
+            std::mutex mtx{};
+            int64_t version{0};
+            int64_t hits{0};
+            int64_t lookups{0};
+            std::list<Entry> entries{};
+            // Keys view the string owned by the entry they point to.
+            std::unordered_map<std::string_view, std::list<Entry>::iterator> lookup{};
+    };
+}
+
+#endif /* RL_AGENTS_ALPHA_ZERO_EVALUATION_CACHE_H_ */
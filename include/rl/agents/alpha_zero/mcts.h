@@ -11,6 +11,7 @@
 #include <rl/simulators/base.h>
 #include <rl/policies/constraints/categorical_mask.h>
 #include <rl/option.h>
+#include <rl/logging/client/base.h>
 
 #include "modules/base.h"
 
@@ -29,6 +30,8 @@ namespace rl::agents::alpha_zero
         : policies{policies}, values{values} {}
     };
 
+    class EvaluationCache;
+
     struct MCTSOptions
     {
         RL_OPTION(torch::Device, module_device) = torch::kCPU;
@@ -42,6 +45,62 @@ namespace rl::agents::alpha_zero
 
         RL_OPTION(float, dirchlet_noise_alpha) = 0.1f;
         RL_OPTION(float, dirchlet_noise_epsilon) = 0.5f;
+
+        // Number of groups the root batch is split into. If larger than one,
+        // inference of one group runs on a separate thread while the next group
+        // is selected and simulated. Cannot be combined with `gumbel`,
+        // `adaptive_check_period` or `expand_all_children`.
+        RL_OPTION(int, pipeline_groups) = 1;
+
+        // If set, evaluations are looked up in the cache before being forwarded
+        // to the inference function.
+        RL_OPTION(std::shared_ptr<EvaluationCache>, evaluation_cache) = nullptr;
+
+        // If positive, nodes keep only the `max_children` legal actions of highest
+        // prior, stored in compact arrays. Zero keeps all `dim` actions.
+        RL_OPTION(int64_t, max_children) = 0;
+        // Progressive widening of sparse nodes. If positive, only the
+        // `ceil(c * N^alpha)` highest prior children of a node with N visits are
+        // considered during selection.
+        RL_OPTION(float, progressive_widening_constant) = 0.0f;
+        RL_OPTION(float, progressive_widening_exponent) = 0.5f;
+
+        // If true, root actions are chosen by Gumbel-Top-k sampling followed by
+        // sequential halving of the simulation budget, instead of PUCT with
+        // Dirchlet noise. Root nodes then carry an improved policy, see
+        // `MCTSNode::improved_policy`. Cannot be combined with `pipeline_groups`,
+        // `adaptive_check_period` or `expand_all_children`.
+        RL_OPTION(bool, gumbel) = false;
+        RL_OPTION(int64_t, gumbel_max_considered_actions) = 16;
+        RL_OPTION(float, gumbel_c_visit) = 50.0f;
+        RL_OPTION(float, gumbel_c_scale) = 1.0f;
+
+        // If positive, the visit distribution of each root is compared every
+        // `adaptive_check_period` simulations, and roots that have converged stop
+        // receiving simulations. The budget of `steps` simulations per root is
+        // shared by the batch, and freed simulations go to unresolved roots, each
+        // capped at `adaptive_max_steps_factor * steps`. Cannot be combined with
+        // `pipeline_groups`, `gumbel` or `expand_all_children`.
+        RL_OPTION(int, adaptive_check_period) = 0;
+        // Converged if the KL divergence between checkpoints is below this value.
+        RL_OPTION(float, adaptive_kl_threshold) = 0.0f;
+        // Converged if the top action is unchanged between checkpoints, and leads
+        // the second best action by this fraction of the visits.
+        RL_OPTION(float, adaptive_margin_threshold) = 0.0f;
+        RL_OPTION(float, adaptive_max_steps_factor) = 2.0f;
+
+        // If true, the first time a node is expanded, all its legal children are
+        // simulated and evaluated in the same batch. Unvisited children are then
+        // backed up directly, without further simulator or inference calls.
+        // Cannot be combined with `gumbel`, `adaptive_check_period` or
+        // `pipeline_groups`.
+        RL_OPTION(bool, expand_all_children) = false;
+        // If positive, expansions of all children are evaluated in chunks of at
+        // most this many states. Otherwise, each expansion step is evaluated in
+        // one inference call, of up to `dim` times the root batch size.
+        RL_OPTION(int64_t, max_inference_batchsize) = 0;
+
+        RL_OPTION(std::shared_ptr<rl::logging::client::Base>, logger) = nullptr;
     };
 
     class MCTSNode;
@@ -58,11 +117,15 @@ namespace rl::agents::alpha_zero
                 const torch::Tensor &state,
                 const torch::Tensor &mask,
                 const torch::Tensor &prior,
-                float value
+                float value,
+                const MCTSOptions &options={}
             );
 
             inline
-            std::shared_ptr<MCTSNode> get_child(int i) const { return children[i]; }
+            std::shared_ptr<MCTSNode> get_child(int i) const {
+                auto slot = slot_of(i);
+                return slot < 0 ? nullptr : children[slot];
+            }
 
             inline
             const torch::Tensor state() const { return state_; }
@@ -80,14 +143,35 @@ namespace rl::agents::alpha_zero
             bool is_root() const { return parent == nullptr; }
 
             inline
-            const torch::Tensor visit_count() const { return N; }
+            bool is_sparse() const { return !child_actions.empty(); }
+
+            const torch::Tensor visit_count() const;
 
             inline float v() const { return value; }
 
-            inline torch::Tensor p() const { return P; }
+            torch::Tensor p() const;
+
+            torch::Tensor q() const;
+
+            // Improved policy of a root node after a Gumbel search, undefined
+            // otherwise.
+            inline
+            const torch::Tensor improved_policy() const { return improved_policy_; }
+
+            // Action chosen by sequential halving in a Gumbel search, -1 otherwise.
+            inline
+            int64_t selected_action() const { return selected_action_; }
+
+            void set_gumbel_result(const torch::Tensor &improved_policy, int64_t selected_action);
+
+            // Legal actions that do not yet have a child node.
+            std::vector<int64_t> unexpanded_actions() const;
 
             MCTSSelectResult select(const MCTSOptions &options={});
 
+            // Selects from the subtree of the given action.
+            MCTSSelectResult select(int64_t action, const MCTSOptions &options={});
+
             void expand(
                 int64_t action,
                 float reward,
@@ -104,6 +188,9 @@ namespace rl::agents::alpha_zero
             void rootify(float noise_epsilon, const torch::Tensor &noise);
 
         private:
+            // Action of each child slot, empty for dense nodes where the slot
+            // equals the action.
+            std::vector<int64_t> child_actions;
             int64_t dim;
             float value;
             bool N_is_zero{true};
@@ -114,13 +201,26 @@ namespace rl::agents::alpha_zero
 
             MCTSNode *parent{nullptr};
             int64_t action{-1};
+            int64_t slot{-1};
             bool terminal_{false};
             float reward_{0.0f};
 
+            torch::Tensor improved_policy_{};
+            int64_t selected_action_{-1};
+
         private:
-            void backup(int64_t action, float value, const MCTSOptions &options);
+            void backup(int64_t slot, float value, const MCTSOptions &options);
+
+            int64_t slot_of(int64_t action) const;
+            int64_t active_children(const MCTSOptions &options) const;
+            torch::Tensor to_dense(const torch::Tensor &values) const;
     };
 
+    // Throws std::invalid_argument if more than one of the search modes
+    // `gumbel`, `adaptive_check_period`, `expand_all_children` and
+    // `pipeline_groups` is enabled.
+    void validate_mcts_options(const MCTSOptions &options);
+
     void mcts(
         std::vector<std::shared_ptr<MCTSNode>> *root_nodes,
         std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn,
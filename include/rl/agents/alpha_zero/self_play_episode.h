@@ -15,8 +15,15 @@ namespace rl::agents::alpha_zero
         torch::Tensor masks;
         // Sequence of actions taken.
         torch::Tensor actions;
+        // Sequence of search policies, i.e. normalized visit counts or improved
+        // policies, computed during self play.
+        torch::Tensor policies;
         // Sequence of (future, discounted) rewards collected during an episode, G.
         torch::Tensor collected_rewards;
+        // Sequence of flags, true for steps whose search policy is stale and is
+        // always searched again during training. Set for episodes relabeled in
+        // hindsight.
+        torch::Tensor reanalyse;
     };
 }
 
@@ -13,6 +13,7 @@
 #include <rl/utils/float_control/fixed.h>
 
 #include "mcts.h"
+#include "evaluation_cache.h"
 #include "self_play_episode.h"
 
 
@@ -33,16 +34,58 @@ namespace rl::agents::alpha_zero
         RL_OPTION(torch::Device, replay_device) = torch::kCPU;
         RL_OPTION(bool, enable_inference_cuda_graph) = true;
         RL_OPTION(bool, enable_training_cuda_graph) = true;
+        // If true, all self play workers share one inference server, batching
+        // requests across workers.
+        RL_OPTION(bool, shared_inference) = false;
+        // If true, training searches also use the shared inference server.
+        RL_OPTION(bool, shared_inference_include_training) = false;
+        // Maximum delay of a request before a partial batch is executed.
+        RL_OPTION(int, shared_inference_max_delay_ms) = 5;
 
         RL_OPTION(float, discount) = 1.0f;
         RL_OPTION(float, c1) = 1.25f;
         RL_OPTION(float, c2) = 19652;
+        // Number of groups each MCTS batch is split into, overlapping inference
+        // of one group with simulation of another. See `MCTSOptions::pipeline_groups`.
+        RL_OPTION(int, mcts_pipeline_groups) = 1;
+        // Maximum number of children per search node, zero keeps all actions. See
+        // `MCTSOptions::max_children`.
+        RL_OPTION(int64_t, mcts_max_children) = 0;
+        RL_OPTION(float, mcts_progressive_widening_constant) = 0.0f;
+        RL_OPTION(float, mcts_progressive_widening_exponent) = 0.5f;
+        // If true, searches use Gumbel root action selection with sequential
+        // halving. See `MCTSOptions::gumbel`.
+        RL_OPTION(bool, mcts_gumbel) = false;
+        RL_OPTION(int64_t, mcts_gumbel_max_considered_actions) = 16;
+        // Adaptive simulation budgets with early stopping of converged roots. See
+        // `MCTSOptions::adaptive_check_period`.
+        RL_OPTION(int, mcts_adaptive_check_period) = 0;
+        RL_OPTION(float, mcts_adaptive_kl_threshold) = 0.0f;
+        RL_OPTION(float, mcts_adaptive_margin_threshold) = 0.0f;
+        // If true, all legal children of a node are expanded in one batch. See
+        // `MCTSOptions::expand_all_children`.
+        RL_OPTION(bool, mcts_expand_all_children) = false;
+        // Size of the evaluation cache shared by all searches, zero disables it.
+        RL_OPTION(size_t, evaluation_cache_size) = 0;
+        // Number of optimizer steps after which cached evaluations are invalidated.
+        // Counted once for all training workers.
+        RL_OPTION(int, evaluation_cache_version_period) = 1;
 
         RL_OPTION(int, training_batchsize) = 128;
         RL_OPTION(int, training_workers) = 1;
+        // If true, training workers compute gradients on their own batches
+        // concurrently, which are averaged into a single optimizer step. The
+        // effective batchsize is then `training_batchsize * training_workers`.
+        // Otherwise, workers take turns stepping the optimizer.
+        RL_OPTION(bool, data_parallel_training) = false;
         RL_OPTION(int, replay_size) = 10000;
         RL_OPTION(int, min_replay_size) = 1000;
         RL_OPTION(int, training_mcts_steps) = 100;
+        // Fraction of each training batch for which the target policy is searched
+        // again with the current parameters. Remaining samples are trained
+        // towards the search policy stored during self play, except samples
+        // relabeled by `hindsight_callback`, which are always reanalysed.
+        RL_OPTION(float, reanalyse_fraction) = 0.0f;
         RL_OPTION(float, training_dirchlet_noise_alpha) = 0.1f;
         RL_OPTION(float, training_dirchlet_noise_epsilon) = 0.5f;
         RL_OPTION(std::shared_ptr<rl::utils::float_control::Base>, training_temperature_control) = std::make_shared<rl::utils::float_control::Fixed>(1.0f);
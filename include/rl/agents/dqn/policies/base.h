@@ -31,6 +31,37 @@ namespace rl::agents::dqn::policies
                 const torch::Tensor &values,
                 const torch::Tensor &masks
             ) = 0;
+
+            /**
+             * @brief Samples actions from the policy given by the output of a DQN
+             * module. Equivalent in distribution to `policy(values, masks)->sample()`,
+             * but policies may override it to sample without materializing the
+             * distribution.
+             * 
+             * @param values DQN values
+             * @param masks Masks for valid actions
+             * @return torch::Tensor Sampled actions
+             */
+            virtual
+            torch::Tensor sample_actions(
+                const torch::Tensor &values,
+                const torch::Tensor &masks
+            ) {
+                return policy(values, masks)->sample();
+            }
+
+        protected:
+            /**
+             * @brief Samples actions uniformly among those valid.
+             * 
+             * @param masks Masks for valid actions
+             * @return torch::Tensor Sampled actions
+             */
+            static
+            torch::Tensor sample_uniform_actions(const torch::Tensor &masks) {
+                auto noise = torch::rand(masks.sizes(), torch::TensorOptions{}.device(masks.device()));
+                return noise.where(masks, torch::full_like(noise, -1.0f)).argmax(-1);
+            }
     };
 }
 
@@ -26,6 +26,11 @@ namespace rl::agents::dqn::policies
                 const torch::Tensor &masks
             ) override;
 
+            torch::Tensor sample_actions(
+                const torch::Tensor &values,
+                const torch::Tensor &masks
+            ) override;
+
         private:
             std::shared_ptr<rl::utils::float_control::Base> epsilon;
     };
@@ -28,6 +28,13 @@ namespace rl::agents::dqn::policies {
 
                 return std::make_unique<rl::policies::Categorical>(probabilities);
             }
+
+            torch::Tensor sample_actions(
+                const torch::Tensor &values,
+                const torch::Tensor &masks
+            ) override {
+                return values.where(masks, torch::zeros_like(values) - INFINITY).argmax(-1);
+            }
     };
 }
 
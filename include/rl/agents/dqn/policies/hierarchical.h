@@ -51,9 +51,17 @@ namespace rl::agents::dqn::policies {
                 const torch::Tensor &masks
             ) override;
 
+            torch::Tensor sample_actions(
+                const torch::Tensor &values,
+                const torch::Tensor &masks
+            ) override;
+
         private:
             std::vector<std::shared_ptr<Base>> policies;
             std::vector<std::shared_ptr<rl::utils::float_control::Base>> probabilities;
+
+        private:
+            std::vector<float> get_probabilities() const;
     };
 }
 
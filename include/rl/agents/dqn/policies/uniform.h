@@ -23,6 +23,13 @@ namespace rl::agents::dqn::policies {
                 auto probability_weights = torch::ones_like(values).where(masks, torch::zeros_like(values));
                 return std::make_unique<rl::policies::Categorical>(probability_weights);
             }
+
+            torch::Tensor sample_actions(
+                const torch::Tensor &values,
+                const torch::Tensor &masks
+            ) override {
+                return sample_uniform_actions(masks);
+            }
     };
 }
 
@@ -29,6 +29,9 @@ namespace rl::agents::dqn::trainers
         RL_OPTION(int, workers) = 4;
         // Batch size per worker
         RL_OPTION(int, worker_batchsize) = 128;
+        // If true, each worker splits its environments into two halves. While one
+        // half is in inference, the other half steps its environments.
+        RL_OPTION(bool, pipelined_workers) = false;
         // Batch size used in training.
         RL_OPTION(int, batch_size) = 64;
         // Gradients are scaled in case their norm is larger than this value.
@@ -8,6 +8,7 @@
 #include <torch/torch.h>
 
 #include <rl/env/state.h>
+#include <rl/utils/reward/batched_n_step_collector.h>
 
 namespace rl::agents::dqn::utils
 {
@@ -26,6 +27,23 @@ namespace rl::agents::dqn::utils
     };
 
     using HindsightReplayCallback = std::function<bool(HindsightReplayEpisode*)>;
+
+    /**
+     * @brief Converts an episode into n step transitions, computed in one vectorized
+     * pass. The result equals that of stepping an `rl::utils::reward::NStepCollector`
+     * through the episode, up to transition order.
+     * 
+     * @param episode Episode, with states constrained by categorical masks.
+     * @param n Number of steps.
+     * @param discount Discount factor.
+     * @return rl::utils::reward::BatchedNStepCollectorTransitions Transitions, with
+     *  states and next states given as {states, masks}.
+     */
+    rl::utils::reward::BatchedNStepCollectorTransitions episode_to_n_step_transitions(
+        const HindsightReplayEpisode &episode,
+        int n,
+        float discount
+    );
 }
 
 #endif /* RL_AGENTS_DQN_UTILS_HINDSIGHT_REPLAY_H_ */
@@ -35,6 +35,10 @@ namespace rl::agents::ppo::trainers
         RL_OPTION(int, envs) = 16;
         // Number of threads on which the data collection is distribution on.
         RL_OPTION(int, env_workers) = 4;
+        // If true, all environments are stepped in lockstep, with one batched forward
+        // pass per time step. Otherwise, each environment runs its own sequence with
+        // batch size one.
+        RL_OPTION(bool, lockstep_rollouts) = false;
         // If true, data is stored on the gpu.
         RL_OPTION(bool, cuda) = false;
 
@@ -0,0 +1,69 @@
+#ifndef INCLUDE_RL_AGENTS_PPO_TRAINERS_BASIC_ROLLOUTS_H_
+#define INCLUDE_RL_AGENTS_PPO_TRAINERS_BASIC_ROLLOUTS_H_
+
+#include <memory>
+#include <vector>
+
+#include <torch/torch.h>
+#include <thread_pool.hpp>
+
+#include "rl/env/env.h"
+#include "rl/policies/constraints/base.h"
+#include "rl/agents/ppo/module.h"
+#include "basic.h"
+
+
+namespace rl::agents::ppo::trainers
+{
+
+    /**
+     * @brief Batch of rollouts gathered by the Basic trainer. All tensors are
+     * batched over (envs, sequence_length), except for `states` that also holds the
+     * final state of each sequence, i.e. (envs, sequence_length + 1).
+     */
+    struct CompiledSequences {
+        torch::Tensor states{};
+        torch::Tensor actions{};
+        torch::Tensor rewards{};
+        torch::Tensor not_terminals{};
+        torch::Tensor action_probabilities{};
+        torch::Tensor state_values{};
+        std::shared_ptr<policies::constraints::Base> constraints{};
+    };
+
+    /**
+     * @brief Gathers one sequence per environment, each executing the model with
+     * batch size one.
+     *
+     * @param envs Environments, one sequence is gathered from each.
+     * @param model PPO model
+     * @param options Trainer options
+     * @param pool Thread pool on which the environments are executed.
+     * @return std::unique_ptr<CompiledSequences> Gathered sequences.
+     */
+    std::unique_ptr<CompiledSequences> run_sequences(
+        const std::vector<std::shared_ptr<env::Base>> &envs,
+        std::shared_ptr<agents::ppo::Module> model,
+        const BasicOptions &options,
+        thread_pool &pool
+    );
+
+    /**
+     * @brief Gathers one sequence per environment, stepping all environments in
+     * lockstep with one batched model execution per time step.
+     *
+     * @param envs Environments, one sequence is gathered from each.
+     * @param model PPO model
+     * @param options Trainer options
+     * @param pool Thread pool on which the environments are executed.
+     * @return std::unique_ptr<CompiledSequences> Gathered sequences.
+     */
+    std::unique_ptr<CompiledSequences> run_lockstep_sequences(
+        const std::vector<std::shared_ptr<env::Base>> &envs,
+        std::shared_ptr<agents::ppo::Module> model,
+        const BasicOptions &options,
+        thread_pool &pool
+    );
+}
+
+#endif /* INCLUDE_RL_AGENTS_PPO_TRAINERS_BASIC_ROLLOUTS_H_ */
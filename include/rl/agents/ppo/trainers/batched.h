@@ -0,0 +1,85 @@
+#ifndef INCLUDE_RL_AGENTS_PPO_TRAINERS_BATCHED_H_
+#define INCLUDE_RL_AGENTS_PPO_TRAINERS_BATCHED_H_
+
+#include <memory>
+#include <chrono>
+
+#include <torch/torch.h>
+
+#include "rl/option.h"
+#include "rl/simulators/base.h"
+#include "rl/agents/ppo/module.h"
+#include "rl/logging/client/base.h"
+
+
+namespace rl::agents::ppo::trainers
+{
+
+    /**
+     * @brief Options for the Batched trainer
+     */
+    struct BatchedOptions{
+        // Epsilon, controlling policy proximity between training steps.
+        RL_OPTION(float, eps) = 0.1;
+        // Reward discount factor.
+        RL_OPTION(float, discount) = 0.99;
+        // Discount factor for generalized advantage estimation.
+        RL_OPTION(float, gae_discount) = 0.95;
+        // Number of update steps per gathered data batch.
+        RL_OPTION(int, update_steps) = 10;
+        // Sequence length of gathered data batches
+        RL_OPTION(int, sequence_length) = 64;
+        // Number of simulated states rolled out in parallel.
+        RL_OPTION(int64_t, batchsize) = 256;
+
+        // Logger used by the trainer.
+        RL_OPTION(std::shared_ptr<rl::logging::client::Base>, logger){};
+        // If true, loss function is logged.
+        RL_OPTION(bool, log_loss) = true;
+        // If true, mean value estimate of initial states is logged.
+        RL_OPTION(bool, log_start_value) = true;
+    };
+
+    /**
+     * @brief PPO trainer operating directly on a batched simulator.
+     * 
+     * The trainer keeps one batch of simulator states and rolls it out for
+     * `sequence_length` steps, where each step is one simulator step and one batched
+     * policy forward pass. Terminal states are replaced by initial states through a
+     * masked reset. Advantages are then computed over the whole batch of sequences,
+     * after which the model is trained as in the `Basic` trainer.
+     */
+    class Batched{
+        public:
+            /**
+             * @brief Construct a new Batched object
+             * 
+             * @param model PPO model
+             * @param optimizer Model optimizer
+             * @param simulator Simulator
+             * @param options Trainer options
+             */
+            Batched(
+                std::shared_ptr<rl::agents::ppo::Module> model,
+                std::shared_ptr<torch::optim::Optimizer> optimizer,
+                std::shared_ptr<rl::simulators::Base> simulator,
+                const BatchedOptions &options={}
+            );
+
+            /**
+             * @brief Starts the training process, and blocks until completed.
+             * 
+             * @param duration Training duration.
+             */
+            template<class Rep, class Period>
+            void run(std::chrono::duration<Rep, Period> duration);
+
+        private:
+            std::shared_ptr<rl::agents::ppo::Module> model;
+            std::shared_ptr<torch::optim::Optimizer> optimizer;
+            std::shared_ptr<rl::simulators::Base> simulator;
+            BatchedOptions options;
+    };
+}
+
+#endif /* INCLUDE_RL_AGENTS_PPO_TRAINERS_BATCHED_H_ */
@@ -0,0 +1,36 @@
+#ifndef INCLUDE_RL_AGENTS_PPO_TRAINERS_BATCHED_ROLLOUTS_H_
+#define INCLUDE_RL_AGENTS_PPO_TRAINERS_BATCHED_ROLLOUTS_H_
+
+#include <memory>
+
+#include <torch/torch.h>
+
+#include "rl/simulators/base.h"
+#include "rl/agents/ppo/module.h"
+#include "basic_rollouts.h"
+#include "batched.h"
+
+
+namespace rl::agents::ppo::trainers
+{
+
+    /**
+     * @brief Rolls out a batch of simulator states for `sequence_length` steps,
+     * with one batched model execution per step. Terminal states are replaced by
+     * initial states, and `states` is updated to the final states of the rollout.
+     *
+     * @param states Simulator states, one sequence is gathered from each.
+     * @param model PPO model
+     * @param simulator Simulator
+     * @param options Trainer options
+     * @return std::unique_ptr<CompiledSequences> Gathered sequences.
+     */
+    std::unique_ptr<CompiledSequences> run_batched_sequences(
+        rl::simulators::States *states,
+        std::shared_ptr<agents::ppo::Module> model,
+        std::shared_ptr<rl::simulators::Base> simulator,
+        const BatchedOptions &options
+    );
+}
+
+#endif /* INCLUDE_RL_AGENTS_PPO_TRAINERS_BATCHED_ROLLOUTS_H_ */
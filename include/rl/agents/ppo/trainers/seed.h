@@ -23,8 +23,17 @@ namespace rl::agents::ppo::trainers
         RL_OPTION(float, eps) = 0.1;
         // Reward discount factor.
         RL_OPTION(float, discount) = 0.99;
-        // Discount factor for generalized advantage estimation.
+        // Discount factor for generalized advantage estimation. Also used as trace
+        // discount when V-trace is enabled.
         RL_OPTION(float, gae_discount) = 0.95;
+        // If true, value targets and advantages are computed using V-trace, correcting
+        // for the lag between the policy acting in the environments and the policy
+        // being trained.
+        RL_OPTION(bool, vtrace) = false;
+        // V-trace clipping threshold of importance weights in temporal differences.
+        RL_OPTION(float, vtrace_rho_max) = 1.0f;
+        // V-trace clipping threshold of importance weights in traces.
+        RL_OPTION(float, vtrace_c_max) = 1.0f;
         
         // Sequence length of each data batch gathered from the environment.
         RL_OPTION(int, sequence_length) = 64;
@@ -46,7 +55,7 @@ namespace rl::agents::ppo::trainers
         RL_OPTION(int, batchsize) = 32;
         // Size of replay, in number of sequences stored.
         RL_OPTION(int64_t, replay_size) = 2000;
-        // Number of sequences collected by the inference process before added to the replay.
+        // Maximum number of completed sequences waiting to be committed to the replay.
         RL_OPTION(int64_t, inference_replay_size) = 500;
         // Device on which data is stored.
         RL_OPTION(torch::Device, replay_device) = torch::kCPU;
@@ -2,6 +2,9 @@
 #define INCLUDE_RL_AGENTS_PPO_TRAINERS_TRAINERS_H_
 
 #include "basic.h"
+#include "basic_rollouts.h"
+#include "batched.h"
+#include "batched_rollouts.h"
 #include "seed.h"
 
 /**
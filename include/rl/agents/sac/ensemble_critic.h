@@ -0,0 +1,94 @@
+#ifndef RL_AGENTS_SAC_ENSEMBLE_CRITIC_H_
+#define RL_AGENTS_SAC_ENSEMBLE_CRITIC_H_
+
+
+#include <vector>
+#include <memory>
+
+#include <torch/torch.h>
+#include <rl/option.h>
+
+#include "critic.h"
+
+namespace rl::agents::sac
+{
+    /**
+     * @brief Ensemble of critics, evaluated in one forward pass. All parameters are
+     * stacked along a leading ensemble dimension, such that the slice of a member
+     * holds exactly its parameters.
+     */
+    class EnsembleCritic : public torch::nn::Module
+    {
+        public:
+            virtual ~EnsembleCritic() = default;
+
+            /**
+             * @brief Evaluates all critics of the ensemble.
+             * 
+             * @param states States, shape (B, ...).
+             * @param actions Actions, shape (B, ...).
+             * @return CriticOutput Values of shape (E, B), where E is the ensemble size.
+             */
+            virtual
+            CriticOutput forward(
+                const torch::Tensor &states,
+                const torch::Tensor &actions
+            ) = 0;
+
+            /**
+             * @return int64_t Number of critics in the ensemble.
+             */
+            virtual int64_t size() const = 0;
+
+            virtual std::unique_ptr<EnsembleCritic> clone() const = 0;
+    };
+
+    /**
+     * @brief Options for `MLPEnsembleCritic`.
+     */
+    struct MLPEnsembleCriticOptions
+    {
+        // Number of critics in the ensemble.
+        RL_OPTION(int64_t, ensemble_size) = 2;
+        // Sizes of hidden layers.
+        RL_OPTION(std::vector<int64_t>, hidden_sizes) = std::vector<int64_t>{64, 64};
+    };
+
+    /**
+     * @brief Ensemble of multilayer perceptron critics, operating on flattened states
+     * concatenated with flattened actions.
+     * 
+     * Weights of all critics are stored stacked along a leading ensemble dimension,
+     * such that each layer of all critics is evaluated by one batched matrix
+     * multiplication.
+     */
+    class MLPEnsembleCritic : public EnsembleCritic
+    {
+        public:
+            /**
+             * @brief Construct a new MLPEnsembleCritic object
+             * 
+             * @param input_size Number of state features plus number of action features.
+             * @param options Options
+             */
+            MLPEnsembleCritic(int64_t input_size, const MLPEnsembleCriticOptions &options={});
+
+            CriticOutput forward(
+                const torch::Tensor &states,
+                const torch::Tensor &actions
+            ) override;
+
+            int64_t size() const override;
+
+            std::unique_ptr<EnsembleCritic> clone() const override;
+
+        private:
+            const int64_t input_size;
+            const MLPEnsembleCriticOptions options;
+            // Shapes (E, in, out) and (E, 1, out).
+            std::vector<torch::Tensor> weights{};
+            std::vector<torch::Tensor> biases{};
+    };
+}
+
+#endif /* RL_AGENTS_SAC_ENSEMBLE_CRITIC_H_ */
@@ -4,6 +4,7 @@
 
 #include "actor.h"
 #include "critic.h"
+#include "ensemble_critic.h"
 
 #include "trainers/trainers.h"
 
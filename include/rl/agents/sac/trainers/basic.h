@@ -9,6 +9,7 @@
 #include <rl/option.h>
 #include <rl/agents/sac/actor.h>
 #include <rl/agents/sac/critic.h>
+#include <rl/agents/sac/ensemble_critic.h>
 #include <rl/env/base.h>
 #include <rl/buffers/tensor.h>
 #include <rl/buffers/samplers/uniform.h>
@@ -70,6 +71,15 @@ namespace rl::agents::sac::trainers
                 const BasicOptions &options={}
             );
 
+            Basic(
+                std::shared_ptr<rl::agents::sac::Actor> actor,
+                std::shared_ptr<rl::agents::sac::EnsembleCritic> critic,
+                std::shared_ptr<torch::optim::Optimizer> actor_optimizer,
+                std::shared_ptr<torch::optim::Optimizer> critic_optimizer,
+                std::shared_ptr<rl::env::Factory> env_factory,
+                const BasicOptions &options={}
+            );
+
             void run(size_t duration);
         
         private:
@@ -79,6 +89,8 @@ namespace rl::agents::sac::trainers
             const std::vector<std::shared_ptr<rl::agents::sac::Critic>> critics;
             const std::shared_ptr<torch::optim::Optimizer> actor_optimizer;
             const std::vector<std::shared_ptr<torch::optim::Optimizer>> critic_optimizers;
+            const std::shared_ptr<rl::agents::sac::EnsembleCritic> critic_ensemble;
+            const std::shared_ptr<torch::optim::Optimizer> critic_ensemble_optimizer;
             const std::shared_ptr<rl::env::Factory> env_factory;
 
             std::shared_ptr<rl::buffers::Tensor> buffer;
@@ -90,9 +102,6 @@ namespace rl::agents::sac::trainers
         private:
             void init_env();
             void initialize_buffer();
-            torch::Tensor u_to_a(const torch::Tensor &u);
-            torch::Tensor a_to_u(const torch::Tensor &a);
-            torch::Tensor log_pi_a(const torch::Tensor &u, const ActorOutput &actor_output);
             void execute_env_step();
             void execute_train_step();
     };
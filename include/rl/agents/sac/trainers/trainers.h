@@ -3,5 +3,6 @@
 
 
 #include "basic.h"
+#include "async.h"
 
 #endif /* RL_AGENTS_SAC_TRAINERS_TRAINERS_H_ */
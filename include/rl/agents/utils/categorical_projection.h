@@ -0,0 +1,34 @@
+#ifndef RL_AGENTS_UTILS_CATEGORICAL_PROJECTION_H_
+#define RL_AGENTS_UTILS_CATEGORICAL_PROJECTION_H_
+
+
+#include <torch/torch.h>
+
+namespace rl::agents::utils
+{
+    /**
+     * @brief Projects the distributions of `rewards + not_terminals * discount * atoms`
+     * onto `atoms`, i.e. the target distribution of a categorical distributional
+     * loss.
+     * 
+     * Executed by the custom op `rl::categorical_projection`, a fused CPU kernel
+     * computing the projection and the scatter in one pass per row. Gradients flow
+     * to `next_distribution` only.
+     * 
+     * @param next_distribution Probabilities of the next distribution, shape (B, N).
+     * @param rewards Rewards, shape (B).
+     * @param not_terminals Not terminal flags, shape (B).
+     * @param atoms Equidistant support, shape (N).
+     * @param discount Discount factor.
+     * @return torch::Tensor Projected distribution, shape (B, N).
+     */
+    torch::Tensor categorical_projection(
+        const torch::Tensor &next_distribution,
+        const torch::Tensor &rewards,
+        const torch::Tensor &not_terminals,
+        const torch::Tensor &atoms,
+        float discount
+    );
+}
+
+#endif /* RL_AGENTS_UTILS_CATEGORICAL_PROJECTION_H_ */
@@ -2,5 +2,6 @@
 #define RL_AGENTS_UTILS_UTILS_H_
 
 #include "distributional_loss.h"
+#include "categorical_projection.h"
 
 #endif /* RL_AGENTS_UTILS_UTILS_H_ */
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <memory>
+#include <mutex>
 
 #include "tensor.h"
 
@@ -31,6 +32,18 @@ namespace rl::buffers
         inline int64_t size() { return objs.size(); }
     };
 
+    /**
+     * @brief Reserved row of a `TensorAndObject` buffer, written in place before
+     * being committed as one sample.
+     */
+    struct TensorAndObjectRow
+    {
+        // Row identifier.
+        int64_t id;
+        // Tensors of the row, shaped as one sample (without batch dimension).
+        std::vector<torch::Tensor> tensors;
+    };
+
     /**
      * @brief FIFO buffer of tensors and objects.
      * 
@@ -128,9 +141,59 @@ namespace rl::buffers
 
             std::unique_ptr<TensorAndObjectBatch<T>> get_all() { return get(torch::arange(size())); }
 
+            /**
+             * @brief Reserves a row in which one sample can be written in place, e.g.
+             * step by step while a sequence is collected. The row is not part of the
+             * buffer until committed. Committed rows are recycled, hence row tensors
+             * are only allocated when no released row is available.
+             * 
+             * @return TensorAndObjectRow Reserved row.
+             */
+            TensorAndObjectRow reserve() {
+                std::lock_guard lock{rows_mtx};
+                if (free_rows.empty()) {
+                    std::vector<torch::Tensor> tensors{};
+                    tensors.reserve(tensor.tensor_shapes().size());
+                    for (int i = 0; i < tensor.tensor_shapes().size(); i++) {
+                        tensors.push_back(torch::empty(tensor.tensor_shapes()[i], tensor.tensor_options()[i]));
+                    }
+                    rows.push_back(tensors);
+                    return {static_cast<int64_t>(rows.size()) - 1, tensors};
+                }
+
+                auto id = free_rows.back();
+                free_rows.pop_back();
+                return {id, rows[id]};
+            }
+
+            /**
+             * @brief Adds a reserved row as one sample to the buffer, and releases the
+             * row for later reservations.
+             * 
+             * @param row Row obtained from `reserve`.
+             * @param obj Object of the sample.
+             * @return torch::Tensor Buffer location of the added sample.
+             */
+            torch::Tensor commit(const TensorAndObjectRow &row, const T &obj) {
+                std::vector<torch::Tensor> tensor_data{};
+                tensor_data.reserve(row.tensors.size());
+                for (const auto &x : row.tensors) {
+                    tensor_data.push_back(x.unsqueeze(0));
+                }
+                auto indices = add(tensor_data, {obj});
+
+                std::lock_guard lock{rows_mtx};
+                free_rows.push_back(row.id);
+                return indices;
+            }
+
         private:
             Tensor tensor;
             std::vector<T> obj_data;
+
+            std::mutex rows_mtx{};
+            std::vector<std::vector<torch::Tensor>> rows{};
+            std::vector<int64_t> free_rows{};
     };
 }
 
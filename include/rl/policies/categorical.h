@@ -42,9 +42,11 @@ namespace rl::policies
             void include(std::shared_ptr<constraints::Base> constraint) override;
 
         private:
-            torch::Tensor probabilities, cumsummed, batchvec, values;
+            torch::Tensor probabilities, values;
             const std::vector<int64_t> sample_shape;
             const int64_t dim;
+            // True if values are the action indices, i.e. no custom values were given.
+            bool values_are_indices{false};
 
             void compute_internals();
     };
@@ -28,6 +28,8 @@ namespace rl::policies
             torch::Tensor mean, std;
             torch::Tensor lower_bound, upper_bound;
             torch::Tensor cdf_lower_bound, cdf_upper_bound;
+            // True once bounds have been included, i.e. samples must be truncated.
+            bool truncated{false};
 
             void compute_cdf_at_bounds();
             torch::Tensor standardize(const torch::Tensor &x) const;
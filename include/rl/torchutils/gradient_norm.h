@@ -2,6 +2,7 @@
 #define RL_TORCHUTILS_GRADIENT_NORM_H_
 
 #include <memory>
+#include <vector>
 
 #include <torch/torch.h>
 
@@ -9,30 +10,89 @@
 namespace rl::torchutils
 {
     inline
-    torch::Tensor compute_gradient_norm(std::shared_ptr<torch::optim::Optimizer> optimizer)
+    std::vector<torch::Tensor> get_gradients(std::shared_ptr<torch::optim::Optimizer> optimizer)
     {
-        torch::NoGradGuard guard{};
-        torch::Tensor grad_norm;
-        bool first{true};
-
+        std::vector<torch::Tensor> gradients{};
         for (const auto &param_group : optimizer->param_groups()) {
             for (const auto &param : param_group.params()) {
                 auto &grad = param.grad();
-                if (!grad.defined()) {
-                    continue;
-                }
-
-                if (first) {
-                    grad_norm = grad.square().sum();
-                    first = false;
-                }
-                else {
-                    grad_norm += grad.square().sum();
+                if (grad.defined()) {
+                    gradients.push_back(grad);
                 }
             }
         }
+        return gradients;
+    }
+
+    inline
+    torch::Tensor compute_gradient_norm(const std::vector<torch::Tensor> &gradients)
+    {
+        torch::NoGradGuard guard{};
+        if (gradients.empty()) {
+            return torch::zeros({});
+        }
+        return torch::stack(torch::_foreach_norm(gradients)).norm();
+    }
+
+    inline
+    torch::Tensor compute_gradient_norm(std::shared_ptr<torch::optim::Optimizer> optimizer)
+    {
+        return compute_gradient_norm(get_gradients(optimizer));
+    }
+
+    /**
+     * @brief Scales all gradients such that their global norm is at most `max_norm`.
+     * Executed with multi tensor kernels, and without synchronizing with the host.
+     * 
+     * @param optimizer Optimizer whose parameter gradients are clipped.
+     * @param max_norm Maximum global gradient norm.
+     * @return torch::Tensor Global gradient norm, before clipping.
+     */
+    inline
+    torch::Tensor clip_gradient_norm(std::shared_ptr<torch::optim::Optimizer> optimizer, float max_norm)
+    {
+        torch::NoGradGuard guard{};
+        auto gradients = get_gradients(optimizer);
+        auto norm = compute_gradient_norm(gradients);
+        if (gradients.empty()) {
+            return norm;
+        }
+        auto factor = (max_norm / (norm + 1e-6)).clamp_max(1.0);
+        torch::_foreach_mul_(gradients, factor);
+        return norm;
+    }
+
+    /**
+     * @brief Scales the gradients of an ensemble such that the gradient norm of
+     * each member is at most `max_norm`. All parameters must be stacked along a
+     * leading ensemble dimension, over which member norms are computed.
+     * 
+     * @param optimizer Optimizer whose parameter gradients are clipped.
+     * @param max_norm Maximum gradient norm of each member.
+     * @return torch::Tensor Gradient norm of each member before clipping, shape (E).
+     */
+    inline
+    torch::Tensor clip_ensemble_gradient_norm(std::shared_ptr<torch::optim::Optimizer> optimizer, float max_norm)
+    {
+        torch::NoGradGuard guard{};
+        auto gradients = get_gradients(optimizer);
+        if (gradients.empty()) {
+            return torch::zeros({0});
+        }
+
+        std::vector<torch::Tensor> squared_norms{}; squared_norms.reserve(gradients.size());
+        for (const auto &gradient : gradients) {
+            squared_norms.push_back(gradient.reshape({gradient.size(0), -1}).square().sum(1));
+        }
+        auto norms = torch::stack(squared_norms).sum(0).sqrt();
+        auto factors = (max_norm / (norms + 1e-6)).clamp_max(1.0);
 
-        return grad_norm.sqrt();
+        for (auto &gradient : gradients) {
+            std::vector<int64_t> shape(gradient.dim(), 1);
+            shape[0] = -1;
+            gradient.mul_(factors.view(shape));
+        }
+        return norms;
     }
 }
 
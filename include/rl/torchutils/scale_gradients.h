@@ -4,6 +4,8 @@
 
 #include <torch/torch.h>
 
+#include "gradient_norm.h"
+
 
 namespace rl::torchutils
 {
@@ -11,17 +13,14 @@ namespace rl::torchutils
     void scale_gradients(std::shared_ptr<torch::optim::Optimizer> optimizer, const torch::Scalar &factor)
     {
         torch::NoGradGuard guard{};
-        for (auto &param_group : optimizer->param_groups()) {
-            for (auto &param : param_group.params()) {
-                assert(param.grad().defined());
-                param.grad().mul_(factor);
-            }
-        }
+        torch::_foreach_mul_(get_gradients(optimizer), factor);
     }
 
     inline
-    void scale_gradients(std::shared_ptr<torch::optim::Optimizer> optimizer, const torch::Tensor &factor) {
-        scale_gradients(optimizer, factor.item());
+    void scale_gradients(std::shared_ptr<torch::optim::Optimizer> optimizer, const torch::Tensor &factor)
+    {
+        torch::NoGradGuard guard{};
+        torch::_foreach_mul_(get_gradients(optimizer), factor);
     }
 }
 
@@ -0,0 +1,43 @@
+#ifndef RL_TORCHUTILS_TARGET_UPDATE_H_
+#define RL_TORCHUTILS_TARGET_UPDATE_H_
+
+
+#include <vector>
+
+#include <torch/torch.h>
+
+
+namespace rl::torchutils
+{
+    /**
+     * @brief Polyak averaging of target parameters, i.e.
+     * `target = (1 - tau) * target + tau * source`, executed with multi tensor
+     * kernels.
+     * 
+     * @param targets Target parameters, updated in place.
+     * @param sources Source parameters, in the same order as `targets`.
+     * @param tau Update rate, in [0, 1].
+     */
+    inline
+    void polyak_update(const std::vector<torch::Tensor> &targets, const std::vector<torch::Tensor> &sources, float tau)
+    {
+        torch::NoGradGuard guard{};
+        torch::_foreach_lerp_(targets, sources, tau);
+    }
+
+    /**
+     * @brief Copies source parameters into target parameters, executed with multi
+     * tensor kernels.
+     * 
+     * @param targets Target parameters, updated in place.
+     * @param sources Source parameters, in the same order as `targets`.
+     */
+    inline
+    void hard_update(const std::vector<torch::Tensor> &targets, const std::vector<torch::Tensor> &sources)
+    {
+        torch::NoGradGuard guard{};
+        torch::_foreach_copy_(targets, sources);
+    }
+}
+
+#endif /* RL_TORCHUTILS_TARGET_UPDATE_H_ */
@@ -8,5 +8,6 @@
 #include "scale_gradients.h"
 #include "execution_unit.h"
 #include "repeat.h"
+#include "target_update.h"
 
 #endif /* RL_TORCHUTILS_TORCHUTILS_H_ */
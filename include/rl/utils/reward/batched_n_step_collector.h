@@ -0,0 +1,91 @@
+#ifndef RL_UTILS_REWARD_BATCHED_N_STEP_COLLECTOR_H_
+#define RL_UTILS_REWARD_BATCHED_N_STEP_COLLECTOR_H_
+
+
+#include <vector>
+
+#include <torch/torch.h>
+
+
+namespace rl::utils::reward
+{
+    /**
+     * @brief Batch of n step transitions, stored column wise. All tensors share the
+     * same leading dimension N, the number of transitions.
+     * 
+     */
+    struct BatchedNStepCollectorTransitions
+    {
+        // State tensors, e.g. states and action masks, each of shape (N, ...).
+        std::vector<torch::Tensor> states;
+        // Actions, shape (N, ...).
+        torch::Tensor actions;
+        // Discounted n step rewards, shape (N).
+        torch::Tensor rewards;
+        // Terminal flags, shape (N).
+        torch::Tensor terminals;
+        // State tensors observed n steps later, each of shape (N, ...). Undefined
+        // in content for terminal transitions.
+        std::vector<torch::Tensor> next_states;
+    };
+
+    /**
+     * @brief Batched version of `NStepCollector`, collecting n step transitions of
+     * B environments stepped in lockstep. Histories are kept in ring tensors of
+     * shape (n, B, ...), such that each step is a fixed number of tensor operations
+     * regardless of B.
+     * 
+     */
+    class BatchedNStepCollector
+    {
+        public:
+            /**
+             * @brief Construct a new batched n step collector.
+             * 
+             * @param n Number of steps.
+             * @param discount Discount factor.
+             * @param batchsize Number of environments, B.
+             */
+            BatchedNStepCollector(int n, float discount, int64_t batchsize);
+
+            /**
+             * @brief Records one step of all environments.
+             * 
+             * @param states State tensors, e.g. states and action masks, each of
+             *  shape (B, ...), in which the actions were taken.
+             * @param actions Actions taken, shape (B, ...).
+             * @param rewards Rewards received, shape (B).
+             * @param terminals Whether the actions terminated the episodes, shape (B).
+             * @return BatchedNStepCollectorTransitions Transitions completed by this
+             *  step.
+             */
+            BatchedNStepCollectorTransitions step(
+                const std::vector<torch::Tensor> &states,
+                const torch::Tensor &actions,
+                const torch::Tensor &rewards,
+                const torch::Tensor &terminals
+            );
+
+        private:
+            const int n;
+            const float discount;
+            const int64_t batchsize;
+            int pointer{0};
+
+            std::vector<torch::Tensor> state_ring;
+            torch::Tensor action_ring;
+            torch::Tensor reward_ring;
+            torch::Tensor age_ring;
+            torch::Tensor valid_ring;
+            torch::Tensor discounts;
+
+        private:
+            void allocate(
+                const std::vector<torch::Tensor> &states,
+                const torch::Tensor &actions,
+                const torch::Tensor &rewards
+            );
+    };
+}
+
+#endif /* RL_UTILS_REWARD_BATCHED_N_STEP_COLLECTOR_H_ */
@@ -0,0 +1,130 @@
+#ifndef RL_UTILS_REWARD_DISCOUNTED_SCAN_H_
+#define RL_UTILS_REWARD_DISCOUNTED_SCAN_H_
+
+
+#include <torch/torch.h>
+
+namespace rl::utils::reward
+{
+    /**
+     * @brief Computes the reversed discounted cumulative sum along the last dimension,
+     * `out[..., t] = values[..., t] + discount * not_terminals[..., t] * out[..., t + 1]`,
+     * with `out[..., -1] = values[..., -1]`.
+     * 
+     * Leading dimensions are flattened into one batch dimension. CPU tensors not
+     * requiring gradients are then handled by the custom op `rl::discounted_cumsum`,
+     * which scans all time steps in one kernel, parallelized across batch chunks.
+     * Other inputs fall back to a time step loop of tensor operations.
+     * 
+     * @param values Values of shape (..., H), where H is the history length.
+     * @param not_terminals Not terminal flags of shape (..., H), resetting the sum
+     *  at terminal steps.
+     * @param discount Discount factor.
+     * @return torch::Tensor Tensor of same shape as `values`.
+     */
+    torch::Tensor discounted_cumsum(
+        const torch::Tensor &values,
+        const torch::Tensor &not_terminals,
+        float discount
+    );
+
+    /**
+     * @brief Computes the reversed discounted cumulative sum of `values`, without
+     * terminal resets. See `discounted_cumsum(values, not_terminals, discount)`.
+     */
+    torch::Tensor discounted_cumsum(const torch::Tensor &values, float discount);
+
+    /**
+     * @brief Computes generalized advantage estimates, GAE(discount, gae_discount).
+     * 
+     * @param rewards Rewards of shape (..., H).
+     * @param values State values of shape (..., H + 1), where the last value
+     *  bootstraps the final state.
+     * @param not_terminals Not terminal flags of shape (..., H).
+     * @param discount Reward discount factor.
+     * @param gae_discount GAE discount factor, often referred to as lambda.
+     * @return torch::Tensor Advantages of shape (..., H).
+     */
+    torch::Tensor generalized_advantages(
+        const torch::Tensor &rewards,
+        const torch::Tensor &values,
+        const torch::Tensor &not_terminals,
+        float discount,
+        float gae_discount
+    );
+
+    /**
+     * @brief V-trace value targets and advantages.
+     */
+    struct VTrace
+    {
+        // Value targets, shape (..., H).
+        torch::Tensor value_targets;
+        // Advantages `r_t + discount * v_{t+1} - V_t`, shape (..., H). Suited for
+        // objectives that apply the importance ratio themselves, e.g. the PPO
+        // surrogate.
+        torch::Tensor advantages;
+        // Advantages weighted by the clipped importance weights rho, shape
+        // (..., H). Suited for plain log probability gradients.
+        torch::Tensor weighted_advantages;
+    };
+
+    /**
+     * @brief Computes V-trace targets and advantages, https://arxiv.org/abs/1802.01561,
+     * correcting for the policy lag between behavior and target policy. Computed
+     * without gradients.
+     * 
+     * With equal behavior and target probabilities, and clipping thresholds of at
+     * least one, the value targets equal `values + generalized_advantages(...)`.
+     * 
+     * @param rewards Rewards of shape (..., H).
+     * @param values State values of shape (..., H + 1).
+     * @param not_terminals Not terminal flags of shape (..., H).
+     * @param behavior_probabilities Probabilities of the taken actions under the
+     *  behavior policy, shape (..., H).
+     * @param target_probabilities Probabilities of the taken actions under the
+     *  target policy, shape (..., H).
+     * @param discount Reward discount factor.
+     * @param trace_discount Trace discount factor, lambda.
+     * @param rho_max Clipping threshold of the importance weights of the temporal
+     *  differences.
+     * @param c_max Clipping threshold of the trace importance weights.
+     * @return VTrace Value targets and advantages.
+     */
+    VTrace vtrace(
+        const torch::Tensor &rewards,
+        const torch::Tensor &values,
+        const torch::Tensor &not_terminals,
+        const torch::Tensor &behavior_probabilities,
+        const torch::Tensor &target_probabilities,
+        float discount,
+        float trace_discount,
+        float rho_max,
+        float c_max
+    );
+
+    /**
+     * @brief Computes n-step returns, bootstrapped with state values. Close to the end
+     * of the history, returns are truncated to the remaining steps and bootstrapped
+     * with the final state value.
+     * 
+     * CPU tensors not requiring gradients are handled by the custom op
+     * `rl::n_step_returns`.
+     * 
+     * @param rewards Rewards of shape (..., H).
+     * @param values State values of shape (..., H + 1).
+     * @param not_terminals Not terminal flags of shape (..., H).
+     * @param discount Discount factor.
+     * @param n Number of steps.
+     * @return torch::Tensor Returns of shape (..., H).
+     */
+    torch::Tensor n_step_returns(
+        const torch::Tensor &rewards,
+        const torch::Tensor &values,
+        const torch::Tensor &not_terminals,
+        float discount,
+        int64_t n
+    );
+}
+
+#endif /* RL_UTILS_REWARD_DISCOUNTED_SCAN_H_ */
@@ -3,6 +3,8 @@
 
 
 #include "n_step_collector.h"
+#include "batched_n_step_collector.h"
 #include "backpropagate.h"
+#include "discounted_scan.h"
 
 #endif /* RL_UTILS_REWARD_REWARD_H_ */
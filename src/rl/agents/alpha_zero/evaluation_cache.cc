@@ -0,0 +1,132 @@
+#include "rl/agents/alpha_zero/evaluation_cache.h"
+
+
+namespace rl::agents::alpha_zero
+{
+    static
+    std::vector<std::string> row_keys(const torch::Tensor &states)
+    {
+        auto n = states.size(0);
+        auto row_bytes = n > 0 ? states.nbytes() / n : 0;
+        auto data = static_cast<const char *>(states.data_ptr());
+
+        // Rows of different dtype or shape may share bytes, so both prefix the key.
+        std::string header{};
+        auto dtype = static_cast<int8_t>(states.scalar_type());
+        header.append(reinterpret_cast<const char *>(&dtype), sizeof(dtype));
+        for (auto size : states.sizes().slice(1)) {
+            header.append(reinterpret_cast<const char *>(&size), sizeof(size));
+        }
+
+        std::vector<std::string> out{}; out.reserve(n);
+        for (int64_t i = 0; i < n; i++) {
+            out.push_back(header);
+            out.back().append(data + i * row_bytes, row_bytes);
+        }
+        return out;
+    }
+
+    EvaluationCache::EvaluationCache(const EvaluationCacheOptions &options)
+    : options{options}
+    {}
+
+    MCTSInferenceResult EvaluationCache::evaluate(
+        const torch::Tensor &states,
+        const std::function<MCTSInferenceResult(const torch::Tensor &)> &inference_fn,
+        torch::Device module_device
+    )
+    {
+        auto cpu_states = states.to(torch::kCPU).contiguous();
+        auto keys = row_keys(cpu_states);
+        int64_t n = keys.size();
+
+        std::vector<torch::Tensor> priors{}; priors.resize(n);
+        std::vector<float> values{}; values.resize(n);
+        std::vector<int64_t> misses{}; misses.reserve(n);
+        int64_t version;
+
+        {
+            std::lock_guard lock{mtx};
+            version = this->version;
+            for (int64_t i = 0; i < n; i++) {
+                auto it = lookup.find(keys[i]);
+                if (it == lookup.end()) {
+                    misses.push_back(i);
+                    continue;
+                }
+                entries.splice(entries.begin(), entries, it->second);
+                priors[i] = it->second->prior;
+                values[i] = it->second->value;
+            }
+        }
+
+        if (misses.size() > 0)
+        {
+            auto miss_indices = torch::tensor(misses, torch::TensorOptions{}.dtype(torch::kLong));
+            auto output = inference_fn(cpu_states.index({miss_indices}).to(module_device));
+            auto miss_priors = output.policies.get_probabilities().to(torch::kCPU);
+            auto miss_values = output.values.to(torch::kCPU).to(torch::kFloat32).contiguous();
+            auto miss_values_accessor = miss_values.accessor<float, 1>();
+
+            for (int64_t j = 0; j < misses.size(); j++) {
+                priors[misses[j]] = miss_priors.index({j});
+                values[misses[j]] = miss_values_accessor[j];
+            }
+
+            std::lock_guard lock{mtx};
+            // Evaluations computed with parameters that have since been replaced
+            // are returned, but not cached.
+            if (version == this->version)
+            {
+                for (int64_t j = 0; j < misses.size(); j++)
+                {
+                    auto &key = keys[misses[j]];
+                    if (lookup.find(key) != lookup.end()) {
+                        continue;
+                    }
+                    entries.push_front(Entry{std::move(key), priors[misses[j]].clone(), values[misses[j]]});
+                    lookup[entries.front().key] = entries.begin();
+
+                    if (entries.size() > options.max_size) {
+                        lookup.erase(entries.back().key);
+                        entries.pop_back();
+                    }
+                }
+            }
+        }
+
+        if (options.logger)
+        {
+            double hit_rate{-1.0};
+            {
+                std::lock_guard lock{mtx};
+                hits += n - misses.size();
+                lookups += n;
+                if (lookups >= options.log_interval) {
+                    hit_rate = static_cast<double>(hits) / lookups;
+                    hits = 0;
+                    lookups = 0;
+                }
+            }
+            if (hit_rate >= 0.0) {
+                options.logger->log_scalar("AlphaZero/Evaluation cache hit rate", hit_rate);
+            }
+        }
+
+        return MCTSInferenceResult{torch::stack(priors), torch::tensor(values)};
+    }
+
+    void EvaluationCache::publish_version()
+    {
+        std::lock_guard lock{mtx};
+        version++;
+        entries.clear();
+        lookup.clear();
+    }
+
+    size_t EvaluationCache::size()
+    {
+        std::lock_guard lock{mtx};
+        return entries.size();
+    }
+}
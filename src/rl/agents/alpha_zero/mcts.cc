@@ -1,37 +1,167 @@
 #include "rl/agents/alpha_zero/mcts.h"
 
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <c10/core/StreamGuard.h>
+#include <c10/cuda/CUDAStream.h>
+
 #include <rl/policies/dirchlet.h>
+#include <rl/agents/alpha_zero/evaluation_cache.h>
 
 
 namespace rl::agents::alpha_zero
 {
     static auto N_options = torch::TensorOptions{}.dtype(torch::kLong);
 
+    static
+    std::vector<int64_t> top_k_legal_actions(
+        const torch::Tensor &prior,
+        const torch::Tensor &mask,
+        int64_t k
+    )
+    {
+        if (k <= 0) {
+            return {};
+        }
+
+        auto cpu_prior = prior.to(torch::kCPU);
+        auto cpu_mask = mask.to(torch::kCPU);
+        k = std::max<int64_t>(1, std::min(k, cpu_mask.sum().item().toLong()));
+
+        auto masked_prior = torch::where(cpu_mask, cpu_prior, torch::full_like(cpu_prior, -1.0f));
+        auto actions = std::get<1>(masked_prior.topk(k)).contiguous();
+        return std::vector<int64_t>(actions.data_ptr<int64_t>(), actions.data_ptr<int64_t>() + k);
+    }
+
+    static
+    torch::Tensor compact_prior(const torch::Tensor &prior, const std::vector<int64_t> &actions)
+    {
+        auto cpu_prior = prior.to(torch::kCPU);
+        if (actions.empty()) {
+            return cpu_prior;
+        }
+
+        auto out = cpu_prior.index({torch::tensor(actions, N_options)});
+        return out / out.sum().clamp_min(1e-8f);
+    }
+
     MCTSNode::MCTSNode(
         const torch::Tensor &state,
         const torch::Tensor &mask,
         const torch::Tensor &prior,
-        float value
+        float value,
+        const MCTSOptions &options
     ) 
         :
+        child_actions{top_k_legal_actions(prior, mask, options.max_children)},
         state_{state},
         mask_{mask.to(torch::kCPU)},
         value{value},
-        P{prior.to(torch::kCPU)},
+        P{compact_prior(prior, child_actions)},
         Q{torch::zeros_like(P)},
         Q_accessor{Q.accessor<float, 1>()},
         N{torch::zeros({Q.size(0)}, N_options)},
         N_accessor{N.accessor<int64_t, 1>()}
     {
         dim = prior.size(0);
-        children.resize(dim);
+        children.resize(P.size(0));
     }
 
     void MCTSNode::rootify(float noise_epsilon, const torch::Tensor &noise) {
         action = -1;
+        slot = -1;
         parent = nullptr;
+        improved_policy_ = torch::Tensor{};
+        selected_action_ = -1;
+
+        if (is_sparse()) {
+            P = (1 - noise_epsilon) * P + noise_epsilon * compact_prior(noise, child_actions);
+        }
+        else {
+            P = (1 - noise_epsilon) * P + noise_epsilon * noise;
+        }
+    }
+
+    const torch::Tensor MCTSNode::visit_count() const
+    {
+        return is_sparse() ? to_dense(N) : N;
+    }
+
+    torch::Tensor MCTSNode::p() const
+    {
+        return is_sparse() ? to_dense(P) : P;
+    }
+
+    torch::Tensor MCTSNode::to_dense(const torch::Tensor &values) const
+    {
+        return torch::zeros({dim}, values.options()).index_put_(
+            {torch::tensor(child_actions, N_options)}, values
+        );
+    }
+
+    torch::Tensor MCTSNode::q() const
+    {
+        return is_sparse() ? to_dense(Q) : Q;
+    }
+
+    void MCTSNode::set_gumbel_result(const torch::Tensor &improved_policy, int64_t selected_action)
+    {
+        improved_policy_ = improved_policy;
+        selected_action_ = selected_action;
+    }
+
+    std::vector<int64_t> MCTSNode::unexpanded_actions() const
+    {
+        auto mask_accessor = mask_.accessor<bool, 1>();
+
+        std::vector<int64_t> out{}; out.reserve(children.size());
+        for (int64_t slot = 0; slot < children.size(); slot++)
+        {
+            if (children[slot]) {
+                continue;
+            }
+            if (is_sparse()) {
+                out.push_back(child_actions[slot]);
+            }
+            else if (mask_accessor[slot]) {
+                out.push_back(slot);
+            }
+        }
+        return out;
+    }
+
+    int64_t MCTSNode::slot_of(int64_t action) const
+    {
+        if (!is_sparse()) {
+            return action;
+        }
+
+        auto it = std::find(child_actions.cbegin(), child_actions.cend(), action);
+        return it == child_actions.cend() ? -1 : it - child_actions.cbegin();
+    }
+
+    int64_t MCTSNode::active_children(const MCTSOptions &options) const
+    {
+        int64_t n = children.size();
+        if (!is_sparse() || options.progressive_widening_constant <= 0.0f) {
+            return n;
+        }
 
-        P = (1 - noise_epsilon) * P + noise_epsilon * noise;
+        auto visits = N.sum().item().toLong();
+        auto widened = static_cast<int64_t>(
+            std::ceil(options.progressive_widening_constant * std::pow(visits, options.progressive_widening_exponent))
+        );
+        return std::clamp<int64_t>(widened, 1, n);
     }
 
     MCTSSelectResult MCTSNode::select(const MCTSOptions &options)
@@ -43,19 +173,42 @@ namespace rl::agents::alpha_zero
             return out;
         }
 
-        int64_t action;
+        int64_t slot;
 
         if (N_is_zero) {
-            action = P.argmax().item().toLong();
+            slot = P.argmax().item().toLong();
+        }
+        else if (is_sparse()) {
+            // Children are sorted by prior, and all legal.
+            auto n = active_children(options);
+            auto P_ = P.narrow(0, 0, n);
+            auto Q_ = Q.narrow(0, 0, n);
+            auto N_ = N.narrow(0, 0, n);
+            auto puct = Q_ + P_ * N.sum().sqrt() / (1 + N_) * (options.c1 + ((N.sum() + options.c2 + 1.0f) / options.c2).log_());
+            slot = torch::argmax(puct).item().toLong();
         }
         else {
             auto puct = Q + P * N.sum().sqrt() / (1 + N) * (options.c1 + ((N.sum() + options.c2 + 1.0f) / options.c2).log_());
             puct = torch::where(mask_, puct, torch::zeros_like(puct) - INFINITY);
-            action = torch::argmax(puct).item().toLong();
+            slot = torch::argmax(puct).item().toLong();
         }
         
-        if (children[action]) {
-            return children[action]->select(options);
+        // When all children are expanded at once, unvisited children are leaves.
+        if (children[slot] && (!options.expand_all_children || N_accessor[slot] > 0)) {
+            return children[slot]->select(options);
+        }
+
+        MCTSSelectResult out{};
+        out.node = this;
+        out.action = is_sparse() ? child_actions[slot] : slot;
+        return out;
+    }
+
+    MCTSSelectResult MCTSNode::select(int64_t action, const MCTSOptions &options)
+    {
+        auto slot = slot_of(action);
+        if (children[slot] && (!options.expand_all_children || N_accessor[slot] > 0)) {
+            return children[slot]->select(options);
         }
 
         MCTSSelectResult out{};
@@ -75,11 +228,12 @@ namespace rl::agents::alpha_zero
         const MCTSOptions &options
     )
     {
-        if (children[action]) {
+        auto slot = slot_of(action);
+        if (children[slot]) {
             // Action was already expanded. This may happen if action resulted in a
             // terminal state.
-            assert(children[action]->terminal_);
-            assert(children[action]->reward_ == reward);
+            assert(children[slot]->terminal_);
+            assert(children[slot]->reward_ == reward);
             assert(terminal);
             return;
         }
@@ -88,11 +242,13 @@ namespace rl::agents::alpha_zero
             next_state,
             next_mask,
             next_prior,
-            next_value.item().toFloat()
+            next_value.item().toFloat(),
+            options
         );
-        children[action] = next_node;
+        children[slot] = next_node;
         next_node->parent = this;
         next_node->action = action;
+        next_node->slot = slot;
         next_node->reward_ = reward;
         next_node->terminal_ = terminal;
     }
@@ -104,17 +260,17 @@ namespace rl::agents::alpha_zero
         }
 
         if (terminal_) {
-            parent->backup(action, reward_, options);
+            parent->backup(slot, reward_, options);
         }
         else {
-            parent->backup(action, reward_ + options.discount * value, options);
+            parent->backup(slot, reward_ + options.discount * value, options);
         }
     }
 
-    void MCTSNode::backup(int64_t action, float value, const MCTSOptions &options)
+    void MCTSNode::backup(int64_t slot, float value, const MCTSOptions &options)
     {
-        Q_accessor[action] = (N_accessor[action] * Q_accessor[action] + value) / (N_accessor[action] + 1);
-        N_accessor[action] = N_accessor[action] + 1;
+        Q_accessor[slot] = (N_accessor[slot] * Q_accessor[slot] + value) / (N_accessor[slot] + 1);
+        N_accessor[slot] = N_accessor[slot] + 1;
 
         if (N_is_zero) {
             N_is_zero = false;
@@ -124,74 +280,592 @@ namespace rl::agents::alpha_zero
             return;
         }
 
-        parent->backup(this->action, reward_ + options.discount * value, options);
+        parent->backup(this->slot, reward_ + options.discount * value, options);
     }
 
-    void mcts(
-        std::vector<std::shared_ptr<MCTSNode>> *root_nodes_,
-        std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn,
-        std::shared_ptr<rl::simulators::Base> simulator,
-        const MCTSOptions &options
-    )
+    namespace
     {
-        auto &root_nodes{*root_nodes_};
-
-        int64_t batchsize = root_nodes.size();
-        int64_t dim = root_nodes.front()->mask().size(0);
-
-        rl::policies::Dirchlet dirchlet_distribution{
-            options.dirchlet_noise_alpha + torch::zeros({batchsize, dim})
-        };
-        auto dirchlet_noise = dirchlet_distribution.sample();
-
-        for (int i = 0; i < batchsize; i++) {
-            root_nodes[i]->rootify(options.dirchlet_noise_epsilon, dirchlet_noise.index({i}));
+        MCTSInferenceResult evaluate(
+            const torch::Tensor &states,
+            const std::function<MCTSInferenceResult(const torch::Tensor &)> &inference_fn,
+            const MCTSOptions &options
+        )
+        {
+            if (options.evaluation_cache) {
+                return options.evaluation_cache->evaluate(states, inference_fn, options.module_device);
+            }
+            return inference_fn(states.to(options.module_device));
         }
 
-        std::vector<MCTSSelectResult> select_results{};
-        select_results.resize(root_nodes.size());
-
-
-        for (int step = 0; step < options.steps; step++) {
-            for (int i = 0; i < root_nodes.size(); i++) {
-                select_results[i] = root_nodes[i]->select(options);
-            }
+        struct SimulationBatch
+        {
+            std::vector<MCTSSelectResult> select_results;
+            rl::simulators::Observations observation;
+            torch::Tensor next_masks;
+        };
 
-            std::vector<torch::Tensor> states{}; states.reserve(root_nodes.size());
-            std::vector<int64_t> actions{}; actions.reserve(root_nodes.size());
-            for (int i = 0; i < root_nodes.size(); i++) {
-                states.push_back(select_results[i].node->state().to(options.sim_device));
-                actions.push_back(select_results[i].action);
+        SimulationBatch simulate(
+            const std::vector<MCTSSelectResult> &select_results,
+            std::shared_ptr<rl::simulators::Base> simulator,
+            const MCTSOptions &options
+        )
+        {
+            SimulationBatch out{};
+            out.select_results = select_results;
+
+            std::vector<torch::Tensor> states{}; states.reserve(select_results.size());
+            std::vector<int64_t> actions{}; actions.reserve(select_results.size());
+            for (const auto &select_result : out.select_results) {
+                states.push_back(select_result.node->state().to(options.sim_device));
+                actions.push_back(select_result.action);
             }
 
-            auto observation = simulator->step(
+            out.observation = simulator->step(
                 torch::stack(states, 0),
                 torch::tensor(actions, torch::TensorOptions{}.dtype(torch::kLong).device(options.sim_device))
             );
+            out.next_masks = std::dynamic_pointer_cast<rl::policies::constraints::CategoricalMask>(
+                out.observation.next_states.action_constraints
+            )->mask();
 
-            auto next_masks = std::dynamic_pointer_cast<rl::policies::constraints::CategoricalMask>(observation.next_states.action_constraints)->mask();
+            return out;
+        }
 
-            auto output = inference_fn(observation.next_states.states.to(options.module_device));
+        SimulationBatch select_and_simulate(
+            const std::vector<std::shared_ptr<MCTSNode>> &root_nodes,
+            int64_t begin,
+            int64_t end,
+            std::shared_ptr<rl::simulators::Base> simulator,
+            const MCTSOptions &options
+        )
+        {
+            std::vector<MCTSSelectResult> select_results{};
+            select_results.resize(end - begin);
+
+            for (int64_t i = begin; i < end; i++) {
+                select_results[i - begin] = root_nodes[i]->select(options);
+            }
+
+            return simulate(select_results, simulator, options);
+        }
+
+        void expand(
+            const SimulationBatch &batch,
+            const MCTSInferenceResult &output,
+            const MCTSOptions &options
+        )
+        {
+            auto &select_results = batch.select_results;
+            auto &observation = batch.observation;
             auto priors = output.policies.get_probabilities().to(torch::kCPU);
             auto value = output.values.to(torch::kCPU);
 
-            for (int i = 0; i < root_nodes.size(); i++) {
+            for (int i = 0; i < select_results.size(); i++) {
                 select_results[i].node->expand(
                     select_results[i].action,
                     observation.rewards.index({i}).item().toFloat(),
                     observation.terminals.index({i}).item().toBool(),
                     observation.next_states.states.index({i}),
-                    next_masks.index({i}),
+                    batch.next_masks.index({i}),
                     priors.index({i}),
                     value.index({i}),
                     options
                 );
             }
+        }
 
-            for (int i = 0; i < root_nodes.size(); i++) {
-                select_results[i].node->get_child(select_results[i].action)->backup();
+        void backup(const std::vector<MCTSSelectResult> &select_results)
+        {
+            for (const auto &select_result : select_results) {
+                select_result.node->get_child(select_result.action)->backup();
             }
         }
+
+        void expand_and_backup(
+            const SimulationBatch &batch,
+            const MCTSInferenceResult &output,
+            const MCTSOptions &options
+        )
+        {
+            expand(batch, output, options);
+            backup(batch.select_results);
+        }
+
+        // Evaluates states in chunks of at most `max_batchsize`.
+        MCTSInferenceResult evaluate_in_chunks(
+            const torch::Tensor &states,
+            const std::function<MCTSInferenceResult(const torch::Tensor &)> &inference_fn,
+            int64_t max_batchsize,
+            const MCTSOptions &options
+        )
+        {
+            if (states.size(0) <= max_batchsize) {
+                return evaluate(states, inference_fn, options);
+            }
+
+            std::vector<torch::Tensor> priors{};
+            std::vector<torch::Tensor> values{};
+            for (int64_t start = 0; start < states.size(0); start += max_batchsize)
+            {
+                auto length = std::min(max_batchsize, states.size(0) - start);
+                auto output = evaluate(states.narrow(0, start, length), inference_fn, options);
+                priors.push_back(output.policies.get_probabilities().to(torch::kCPU));
+                values.push_back(output.values.to(torch::kCPU));
+            }
+
+            return MCTSInferenceResult{torch::cat(priors), torch::cat(values)};
+        }
+
+        void mcts_expand_all(
+            const std::vector<std::shared_ptr<MCTSNode>> &root_nodes,
+            std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn,
+            std::shared_ptr<rl::simulators::Base> simulator,
+            const MCTSOptions &options
+        )
+        {
+            for (int step = 0; step < options.steps; step++)
+            {
+                std::vector<MCTSSelectResult> leaves{}; leaves.reserve(root_nodes.size());
+                std::vector<MCTSSelectResult> expansions{};
+                for (const auto &root : root_nodes)
+                {
+                    auto select_result = root->select(options);
+                    leaves.push_back(select_result);
+
+                    if (select_result.node->get_child(select_result.action)) {
+                        continue;
+                    }
+
+                    auto actions = select_result.node->unexpanded_actions();
+                    if (std::find(actions.cbegin(), actions.cend(), select_result.action) == actions.cend()) {
+                        actions.push_back(select_result.action);
+                    }
+                    for (auto action : actions) {
+                        expansions.push_back(MCTSSelectResult{select_result.node, action});
+                    }
+                }
+
+                if (!expansions.empty()) {
+                    auto batch = simulate(expansions, simulator, options);
+                    auto &states = batch.observation.next_states.states;
+                    auto output = options.max_inference_batchsize > 0
+                        ? evaluate_in_chunks(states, inference_fn, options.max_inference_batchsize, options)
+                        : evaluate(states, inference_fn, options);
+                    expand(batch, output, options);
+                }
+
+                backup(leaves);
+            }
+        }
+
+        void mcts_serial(
+            const std::vector<std::shared_ptr<MCTSNode>> &root_nodes,
+            std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn,
+            std::shared_ptr<rl::simulators::Base> simulator,
+            const MCTSOptions &options
+        )
+        {
+            for (int step = 0; step < options.steps; step++) {
+                auto batch = select_and_simulate(root_nodes, 0, root_nodes.size(), simulator, options);
+                auto output = evaluate(batch.observation.next_states.states, inference_fn, options);
+                expand_and_backup(batch, output, options);
+            }
+        }
+
+        // Executes inference requests, in order, on a single thread that lives
+        // for the duration of a search.
+        class InferenceWorker
+        {
+            public:
+                InferenceWorker(
+                    std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn,
+                    std::optional<c10::Stream> stream
+                ) : inference_fn{inference_fn}, stream{stream}
+                {
+                    thread = std::thread{&InferenceWorker::worker, this};
+                }
+
+                ~InferenceWorker()
+                {
+                    {
+                        std::lock_guard lock{mtx};
+                        running = false;
+                    }
+                    cv.notify_one();
+                    thread.join();
+                }
+
+                std::future<MCTSInferenceResult> submit(const torch::Tensor &states)
+                {
+                    std::packaged_task<MCTSInferenceResult()> task{
+                        [this, states] () { return inference_fn(states); }
+                    };
+                    auto out = task.get_future();
+                    {
+                        std::lock_guard lock{mtx};
+                        tasks.push(std::move(task));
+                    }
+                    cv.notify_one();
+                    return out;
+                }
+
+            private:
+                std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn;
+                std::optional<c10::Stream> stream;
+                std::mutex mtx{};
+                std::condition_variable cv{};
+                std::queue<std::packaged_task<MCTSInferenceResult()>> tasks{};
+                bool running{true};
+                std::thread thread;
+
+                void worker()
+                {
+                    c10::OptionalStreamGuard stream_guard{stream};
+                    while (true)
+                    {
+                        std::packaged_task<MCTSInferenceResult()> task{};
+                        {
+                            std::unique_lock lock{mtx};
+                            cv.wait(lock, [this] () { return !running || !tasks.empty(); });
+                            if (tasks.empty()) {
+                                return;
+                            }
+                            task = std::move(tasks.front());
+                            tasks.pop();
+                        }
+                        task();
+                    }
+                }
+        };
+
+        void mcts_pipelined(
+            const std::vector<std::shared_ptr<MCTSNode>> &root_nodes,
+            std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn,
+            std::shared_ptr<rl::simulators::Base> simulator,
+            const MCTSOptions &options
+        )
+        {
+            int64_t batchsize = root_nodes.size();
+            int64_t groups = std::min<int64_t>(options.pipeline_groups, batchsize);
+
+            std::vector<int64_t> bounds{}; bounds.reserve(groups + 1);
+            for (int64_t g = 0; g <= groups; g++) {
+                bounds.push_back(g * batchsize / groups);
+            }
+
+            // Inference runs on a separate thread, and should be executed on the
+            // same stream as the calling thread.
+            std::optional<c10::Stream> stream{};
+            if (options.module_device.is_cuda()) {
+                stream = c10::cuda::getCurrentCUDAStream(options.module_device.index());
+            }
+
+            InferenceWorker worker{
+                [&inference_fn, &options] (const torch::Tensor &states) {
+                    return evaluate(states, inference_fn, options);
+                },
+                stream
+            };
+
+            // At most one group is in inference at any given time. While it runs,
+            // the next group is selected and simulated on this thread. Groups
+            // hold disjoint trees, hence the order of expansions does not matter.
+            std::optional<SimulationBatch> pending_batch{};
+            std::future<MCTSInferenceResult> pending_output{};
+
+            for (int step = 0; step < options.steps; step++) {
+                for (int64_t g = 0; g < groups; g++) {
+                    auto batch = select_and_simulate(root_nodes, bounds[g], bounds[g + 1], simulator, options);
+
+                    if (pending_batch) {
+                        expand_and_backup(*pending_batch, pending_output.get(), options);
+                    }
+
+                    pending_output = worker.submit(batch.observation.next_states.states);
+                    pending_batch = std::move(batch);
+                }
+            }
+
+            if (pending_batch) {
+                expand_and_backup(*pending_batch, pending_output.get(), options);
+            }
+        }
+
+        torch::Tensor visit_distribution(const MCTSNode &node)
+        {
+            auto N = node.visit_count().to(torch::kFloat32);
+            return N / N.sum().clamp_min(1.0f);
+        }
+
+        bool has_converged(const torch::Tensor &previous, const torch::Tensor &current, const MCTSOptions &options)
+        {
+            if (options.adaptive_kl_threshold > 0.0f) {
+                auto kl = (current * ((current + 1e-8f).log() - (previous + 1e-8f).log())).sum();
+                if (kl.item().toFloat() < options.adaptive_kl_threshold) {
+                    return true;
+                }
+            }
+
+            if (options.adaptive_margin_threshold > 0.0f) {
+                if (current.size(0) < 2) {
+                    return true;
+                }
+
+                auto [top_values, top_actions] = current.topk(2);
+                auto same_top_action = previous.argmax().item().toLong() == top_actions.index({0}).item().toLong();
+                auto margin = (top_values.index({0}) - top_values.index({1})).item().toFloat();
+                if (same_top_action && margin >= options.adaptive_margin_threshold) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void mcts_adaptive(
+            const std::vector<std::shared_ptr<MCTSNode>> &root_nodes,
+            std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn,
+            std::shared_ptr<rl::simulators::Base> simulator,
+            const MCTSOptions &options
+        )
+        {
+            int64_t batchsize = root_nodes.size();
+            int64_t budget = options.steps * batchsize;
+            auto max_steps = static_cast<int64_t>(options.steps * options.adaptive_max_steps_factor);
+
+            std::vector<int64_t> simulations(batchsize, 0);
+            // The first checkpoint is taken after `adaptive_check_period`
+            // simulations, convergence is only tested from the second onwards.
+            std::vector<torch::Tensor> checkpoints(batchsize);
+            std::vector<int64_t> active{}; active.reserve(batchsize);
+            for (int64_t i = 0; i < batchsize; i++) {
+                active.push_back(i);
+            }
+
+            std::vector<MCTSSelectResult> select_results{};
+            for (int64_t step = 1; !active.empty() && budget > 0; step++)
+            {
+                if (active.size() > budget) {
+                    active.resize(budget);
+                }
+
+                select_results.clear();
+                for (auto i : active) {
+                    select_results.push_back(root_nodes[i]->select(options));
+                }
+
+                auto batch = simulate(select_results, simulator, options);
+                auto output = evaluate(batch.observation.next_states.states, inference_fn, options);
+                expand_and_backup(batch, output, options);
+                budget -= active.size();
+
+                std::vector<int64_t> unresolved{}; unresolved.reserve(active.size());
+                for (auto i : active)
+                {
+                    simulations[i]++;
+                    if (simulations[i] >= max_steps) {
+                        continue;
+                    }
+
+                    if (step % options.adaptive_check_period == 0) {
+                        auto current = visit_distribution(*root_nodes[i]);
+                        auto converged = checkpoints[i].defined() && has_converged(checkpoints[i], current, options);
+                        checkpoints[i] = current;
+                        if (converged) {
+                            continue;
+                        }
+                    }
+
+                    unresolved.push_back(i);
+                }
+                active = std::move(unresolved);
+            }
+
+            if (options.logger) {
+                int64_t total = std::accumulate(simulations.begin(), simulations.end(), int64_t{0});
+                options.logger->log_scalar("AlphaZero/MCTS simulations per root", static_cast<double>(total) / batchsize);
+            }
+        }
+
+        // Visit count that the next considered action must have, for each
+        // simulation, when sequentially halving `m` actions over `n` simulations.
+        std::vector<int64_t> sequence_of_considered_visits(int64_t m, int64_t n)
+        {
+            std::vector<int64_t> out{}; out.reserve(n);
+            if (m <= 1) {
+                for (int64_t i = 0; i < n; i++) {
+                    out.push_back(i);
+                }
+                return out;
+            }
+
+            auto phases = static_cast<int64_t>(std::ceil(std::log2(m)));
+            std::vector<int64_t> visits(m, 0);
+            auto considered = m;
+
+            while (out.size() < n)
+            {
+                auto extra_visits = std::max<int64_t>(1, n / (phases * considered));
+                for (int64_t i = 0; i < extra_visits; i++) {
+                    for (int64_t j = 0; j < considered; j++) {
+                        out.push_back(visits[j]++);
+                    }
+                }
+                considered = std::max<int64_t>(2, considered / 2);
+            }
+
+            out.resize(n);
+            return out;
+        }
+
+        // Monotonically transformed completed Q values, sigma(completed Q), of a root
+        // node. Unvisited actions are completed with the mixed value estimate.
+        torch::Tensor transformed_completed_q(const MCTSNode &node, const MCTSOptions &options)
+        {
+            auto N = node.visit_count().to(torch::kFloat32);
+            auto P = node.p();
+            auto Q = node.q();
+            auto visited = N > 0;
+            auto N_sum = N.sum().item().toFloat();
+
+            auto v_mix = node.v();
+            if (N_sum > 0) {
+                auto P_visited = (P * visited).sum().clamp_min(1e-8f);
+                auto Q_weighted = ((P * Q * visited).sum() / P_visited).item().toFloat();
+                v_mix = (v_mix + N_sum * Q_weighted) / (1.0f + N_sum);
+            }
+
+            auto completed_q = torch::where(visited, Q, torch::full_like(Q, v_mix));
+            auto q_min = completed_q.min();
+            auto q_max = completed_q.max();
+            auto normalized_q = (completed_q - q_min) / (q_max - q_min).clamp_min(1e-8f);
+
+            return (options.gumbel_c_visit + N.max()) * options.gumbel_c_scale * normalized_q;
+        }
+
+        void mcts_gumbel(
+            const std::vector<std::shared_ptr<MCTSNode>> &root_nodes,
+            std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn,
+            std::shared_ptr<rl::simulators::Base> simulator,
+            const MCTSOptions &options
+        )
+        {
+            int64_t batchsize = root_nodes.size();
+
+            std::vector<torch::Tensor> scores{}; scores.reserve(batchsize);
+            std::vector<torch::Tensor> legal{}; legal.reserve(batchsize);
+            std::vector<torch::Tensor> visits{}; visits.reserve(batchsize);
+            std::vector<std::vector<int64_t>> considered_visits{}; considered_visits.reserve(batchsize);
+
+            for (const auto &root : root_nodes)
+            {
+                auto P = root->p();
+                legal.push_back(root->mask() & (P > 0));
+                auto gumbel = -(-torch::rand_like(P).clamp_min_(1e-20f).log_()).log_();
+                scores.push_back(torch::where(legal.back(), gumbel + P.log(), torch::full_like(P, -INFINITY)));
+                visits.push_back(torch::zeros(P.sizes(), N_options));
+
+                auto m = std::min<int64_t>(options.gumbel_max_considered_actions, legal.back().sum().item().toLong());
+                considered_visits.push_back(sequence_of_considered_visits(m, options.steps));
+            }
+
+            std::vector<MCTSSelectResult> select_results{};
+            select_results.resize(batchsize);
+
+            for (int step = 0; step < options.steps; step++)
+            {
+                for (int64_t i = 0; i < batchsize; i++)
+                {
+                    auto considered = legal[i] & (visits[i] == considered_visits[i][step]);
+                    if (!considered.any().item().toBool()) {
+                        considered = legal[i];
+                    }
+                    auto to_argmax = torch::where(
+                        considered,
+                        scores[i] + transformed_completed_q(*root_nodes[i], options),
+                        torch::full_like(scores[i], -INFINITY)
+                    );
+                    auto action = to_argmax.argmax().item().toLong();
+                    visits[i][action] += 1;
+                    select_results[i] = root_nodes[i]->select(action, options);
+                }
+
+                auto batch = simulate(select_results, simulator, options);
+                auto output = evaluate(batch.observation.next_states.states, inference_fn, options);
+                expand_and_backup(batch, output, options);
+            }
+
+            for (int64_t i = 0; i < batchsize; i++)
+            {
+                auto &root = root_nodes[i];
+                auto sigma_q = transformed_completed_q(*root, options);
+
+                auto improved_logits = torch::where(legal[i], root->p().log() + sigma_q, torch::full_like(sigma_q, -INFINITY));
+                auto improved_policy = torch::softmax(improved_logits, 0);
+
+                auto considered = legal[i] & (visits[i] == visits[i].max());
+                auto to_argmax = torch::where(considered, scores[i] + sigma_q, torch::full_like(sigma_q, -INFINITY));
+
+                root->set_gumbel_result(improved_policy, to_argmax.argmax().item().toLong());
+            }
+        }
+    }
+
+    void validate_mcts_options(const MCTSOptions &options)
+    {
+        std::vector<std::string> modes{};
+        if (options.gumbel) modes.push_back("gumbel");
+        if (options.adaptive_check_period > 0) modes.push_back("adaptive_check_period");
+        if (options.expand_all_children) modes.push_back("expand_all_children");
+        if (options.pipeline_groups > 1) modes.push_back("pipeline_groups");
+
+        if (modes.size() > 1) {
+            std::string message{"MCTS search modes cannot be combined, got"};
+            for (const auto &mode : modes) message += " `" + mode + "`";
+            throw std::invalid_argument{message + "."};
+        }
+    }
+
+    void mcts(
+        std::vector<std::shared_ptr<MCTSNode>> *root_nodes_,
+        std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn,
+        std::shared_ptr<rl::simulators::Base> simulator,
+        const MCTSOptions &options
+    )
+    {
+        validate_mcts_options(options);
+        auto &root_nodes{*root_nodes_};
+
+        int64_t batchsize = root_nodes.size();
+        int64_t dim = root_nodes.front()->mask().size(0);
+
+        rl::policies::Dirchlet dirchlet_distribution{
+            options.dirchlet_noise_alpha + torch::zeros({batchsize, dim})
+        };
+        auto dirchlet_noise = dirchlet_distribution.sample();
+
+        // Gumbel search explores through the sampled Gumbel noise instead of
+        // Dirichlet noise on the priors.
+        auto noise_epsilon = options.gumbel ? 0.0f : options.dirchlet_noise_epsilon;
+        for (int i = 0; i < batchsize; i++) {
+            root_nodes[i]->rootify(noise_epsilon, dirchlet_noise.index({i}));
+        }
+
+        if (options.gumbel) {
+            mcts_gumbel(root_nodes, inference_fn, simulator, options);
+        }
+        else if (options.adaptive_check_period > 0) {
+            mcts_adaptive(root_nodes, inference_fn, simulator, options);
+        }
+        else if (options.expand_all_children) {
+            mcts_expand_all(root_nodes, inference_fn, simulator, options);
+        }
+        else if (options.pipeline_groups > 1 && batchsize > 1) {
+            mcts_pipelined(root_nodes, inference_fn, simulator, options);
+        }
+        else {
+            mcts_serial(root_nodes, inference_fn, simulator, options);
+        }
     }
 
     std::vector<std::shared_ptr<MCTSNode>> mcts(
@@ -202,7 +876,8 @@ namespace rl::agents::alpha_zero
         const MCTSOptions &options
     )
     {
-        auto output = inference_fn(states.to(options.module_device));
+        validate_mcts_options(options);
+        auto output = evaluate(states, inference_fn, options);
         output.policies.include(masks);
 
         auto priors = output.policies.get_probabilities().to(torch::kCPU);
@@ -216,7 +891,8 @@ namespace rl::agents::alpha_zero
                 states.index({i}),
                 masks->mask().index({i}),
                 priors.index({i}),
-                values.index({i}).item().toFloat()
+                values.index({i}).item().toFloat(),
+                options
             );
         }
 
@@ -1,5 +1,7 @@
 #include "rl/agents/alpha_zero/trainer.h"
 
+#include <atomic>
+#include <functional>
 #include <mutex>
 
 #include <rl/agents/alpha_zero/self_play_episode.h>
@@ -25,6 +27,13 @@ namespace rl::agents::alpha_zero
         module{module}, optimizer{optimizer},
         simulator{simulator}, options{options}
     {
+        validate_mcts_options(
+            MCTSOptions{}
+                .pipeline_groups_(options.mcts_pipeline_groups)
+                .gumbel_(options.mcts_gumbel)
+                .adaptive_check_period_(options.mcts_adaptive_check_period)
+                .expand_all_children_(options.mcts_expand_all_children)
+        );
         init_buffer();
     }
 
@@ -39,12 +48,16 @@ namespace rl::agents::alpha_zero
             std::vector{
                 state.sizes().vec(),
                 mask.sizes().vec(),
+                std::vector<int64_t>{},
+                mask.sizes().vec(),
                 std::vector<int64_t>{}
             },
             std::vector{
                 torch::TensorOptions{}.dtype(state.dtype()).device(options.replay_device),
                 torch::TensorOptions{}.dtype(mask.dtype()).device(options.replay_device),
-                torch::TensorOptions{}.dtype(torch::kFloat32).device(options.replay_device)
+                torch::TensorOptions{}.dtype(torch::kFloat32).device(options.replay_device),
+                torch::TensorOptions{}.dtype(torch::kFloat32).device(options.replay_device),
+                torch::TensorOptions{}.dtype(torch::kBool).device(options.replay_device)
             }
         );
 
@@ -57,6 +70,46 @@ namespace rl::agents::alpha_zero
         episode_queue = make_shared<thread_safe::Queue<SelfPlayEpisode>>(1000);
         auto result_tracker = make_shared<ResultTracker>(options.logger);
 
+        shared_ptr<EvaluationCache> evaluation_cache{nullptr};
+        if (options.evaluation_cache_size > 0) {
+            evaluation_cache = make_shared<EvaluationCache>(
+                EvaluationCacheOptions{}
+                    .max_size_(options.evaluation_cache_size)
+                    .logger_(options.logger)
+            );
+        }
+
+        // Expanding all children evaluates up to `dim` states per root in one
+        // inference call.
+        int64_t expansion_factor{1};
+        if (options.mcts_expand_all_children) {
+            expansion_factor = get_mask(*simulator->reset(1).action_constraints).size(-1);
+        }
+
+        shared_ptr<InferenceServer> inference_server{nullptr};
+        shared_ptr<InferenceServer> training_inference_server{nullptr};
+        if (options.shared_inference) {
+            auto max_batchsize = options.self_play_batchsize * options.self_play_workers * expansion_factor;
+            if (options.shared_inference_include_training) {
+                max_batchsize += options.training_batchsize * options.training_workers * expansion_factor;
+            }
+
+            inference_server = make_shared<InferenceServer>(
+                module,
+                InferenceServerOptions{}
+                    .max_batchsize_(max_batchsize)
+                    .max_delay_ms_(options.shared_inference_max_delay_ms)
+                    .module_device_(options.module_device)
+                    .enable_cuda_graph_inference_(options.enable_inference_cuda_graph)
+                    .logger_(options.logger)
+            );
+            inference_server->start();
+
+            if (options.shared_inference_include_training) {
+                training_inference_server = inference_server;
+            }
+        }
+
         vector<unique_ptr<SelfPlayWorker>> self_play_workers{};
         self_play_workers.reserve(options.self_play_workers);
         for (int i = 0; i < options.self_play_workers; i++) {
@@ -75,6 +128,7 @@ namespace rl::agents::alpha_zero
                         .max_episode_length_(options.max_episode_length)
                         .temperature_control_(options.self_play_temperature_control)
                         .hindsight_callback_(options.hindsight_callback)
+                        .inference_server_(inference_server)
                         .mcts_options_(
                             MCTSOptions{}
                                 .dirchlet_noise_alpha_(options.self_play_dirchlet_noise_alpha)
@@ -85,12 +139,45 @@ namespace rl::agents::alpha_zero
                                 .module_device_(options.module_device)
                                 .sim_device_(options.sim_device)
                                 .steps_(options.self_play_mcts_steps)
+                                .pipeline_groups_(options.mcts_pipeline_groups)
+                                .evaluation_cache_(evaluation_cache)
+                                .max_children_(options.mcts_max_children)
+                                .progressive_widening_constant_(options.mcts_progressive_widening_constant)
+                                .progressive_widening_exponent_(options.mcts_progressive_widening_exponent)
+                                .gumbel_(options.mcts_gumbel)
+                                .gumbel_max_considered_actions_(options.mcts_gumbel_max_considered_actions)
+                                .adaptive_check_period_(options.mcts_adaptive_check_period)
+                                .adaptive_kl_threshold_(options.mcts_adaptive_kl_threshold)
+                                .adaptive_margin_threshold_(options.mcts_adaptive_margin_threshold)
+                                .expand_all_children_(options.mcts_expand_all_children)
+                                .max_inference_batchsize_(options.mcts_expand_all_children ? options.self_play_batchsize * expansion_factor : 0)
+                                .logger_(options.logger)
                         )
                 )
             );
         }
         
+        // Optimizer steps are counted once for all training workers, also when
+        // data parallel workers share each step, and the evaluation cache is
+        // versioned from this single counter.
+        function<void()> on_optimizer_step{nullptr};
+        if (evaluation_cache) {
+            auto optimizer_steps = make_shared<atomic<int64_t>>(0);
+            on_optimizer_step = [evaluation_cache, optimizer_steps, period = options.evaluation_cache_version_period] () {
+                if (++(*optimizer_steps) % period == 0) {
+                    evaluation_cache->publish_version();
+                }
+            };
+        }
+
         auto optimizer_step_mtx = make_shared<mutex>();
+        shared_ptr<trainer_impl::GradientReducer> gradient_reducer{nullptr};
+        if (options.data_parallel_training) {
+            gradient_reducer = make_shared<trainer_impl::GradientReducer>(
+                optimizer, optimizer_step_mtx, options.training_workers, on_optimizer_step
+            );
+        }
+
         vector<unique_ptr<trainer_impl::Trainer>> trainers{};
         trainers.reserve(options.training_workers);
 
@@ -112,6 +199,10 @@ namespace rl::agents::alpha_zero
                         .enable_cuda_graph_training_(options.enable_training_cuda_graph)
                         .enable_cuda_graph_inference_(options.enable_inference_cuda_graph)
                         .temperature_control_(options.training_temperature_control)
+                        .on_optimizer_step_(on_optimizer_step)
+                        .reanalyse_fraction_(options.reanalyse_fraction)
+                        .inference_server_(training_inference_server)
+                        .gradient_reducer_(gradient_reducer)
                         .mcts_options_(
                             MCTSOptions{}
                                 .c1_(options.c1)
@@ -122,6 +213,19 @@ namespace rl::agents::alpha_zero
                                 .module_device_(options.module_device)
                                 .sim_device_(options.sim_device)
                                 .steps_(options.training_mcts_steps)
+                                .pipeline_groups_(options.mcts_pipeline_groups)
+                                .evaluation_cache_(evaluation_cache)
+                                .max_children_(options.mcts_max_children)
+                                .progressive_widening_constant_(options.mcts_progressive_widening_constant)
+                                .progressive_widening_exponent_(options.mcts_progressive_widening_exponent)
+                                .gumbel_(options.mcts_gumbel)
+                                .gumbel_max_considered_actions_(options.mcts_gumbel_max_considered_actions)
+                                .adaptive_check_period_(options.mcts_adaptive_check_period)
+                                .adaptive_kl_threshold_(options.mcts_adaptive_kl_threshold)
+                                .adaptive_margin_threshold_(options.mcts_adaptive_margin_threshold)
+                                .expand_all_children_(options.mcts_expand_all_children)
+                                .max_inference_batchsize_(options.mcts_expand_all_children ? options.training_batchsize * expansion_factor : 0)
+                                .logger_(options.logger)
                         )
                 )
             );
@@ -144,12 +248,18 @@ namespace rl::agents::alpha_zero
         }
 
         running = false;
+        if (gradient_reducer) {
+            gradient_reducer->stop();
+        }
         for (auto &trainer_worker : trainers) {
             trainer_worker->stop();
         }
         for (auto &self_play_worker : self_play_workers) {
             self_play_worker->stop();
         }
+        if (inference_server) {
+            inference_server->stop();
+        }
         if (queue_consuming_thread.joinable()) {
             queue_consuming_thread.join();
         }
@@ -168,7 +278,13 @@ namespace rl::agents::alpha_zero
             }
 
             auto episode = *episode_ptr;
-            buffer->add({episode.states.to(options.replay_device), episode.masks.to(options.replay_device), episode.collected_rewards.to(options.replay_device)});
+            buffer->add({
+                episode.states.to(options.replay_device),
+                episode.masks.to(options.replay_device),
+                episode.collected_rewards.to(options.replay_device),
+                episode.policies.to(options.replay_device),
+                episode.reanalyse.to(options.replay_device)
+            });
         }
     }
 
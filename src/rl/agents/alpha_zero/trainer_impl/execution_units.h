@@ -89,6 +89,49 @@ namespace trainer_impl
             std::shared_ptr<modules::Base> module;
             std::shared_ptr<torch::optim::Optimizer> optimizer;
     };
+
+    // Accumulates gradients of the loss into the module parameters, without
+    // stepping. Used by data parallel training workers, see `GradientReducer`.
+    class GradientUnit : public rl::torchutils::ExecutionUnit
+    {
+        public:
+            GradientUnit(
+                int max_batchsize,
+                torch::Device device,
+                std::shared_ptr<modules::Base> module,
+                bool use_cuda_graph
+            ) : rl::torchutils::ExecutionUnit(
+                    max_batchsize, device, use_cuda_graph
+                ),
+                module{module}
+            {
+                if (use_cuda_graph) {
+                    throw std::runtime_error{"CUDAGraph for training not yet supported."};
+                }
+            }
+
+            rl::torchutils::ExecutionUnitOutput forward(const std::vector<torch::Tensor> &inputs)
+            {
+                auto &states = inputs[0];
+                auto &posteriors = inputs[1];
+                auto &rewards = inputs[2];
+                auto module_output = module->forward(states);
+                auto policy_loss = module_output->policy_loss(posteriors).mean();
+                auto value_loss = module_output->value_loss(rewards).mean();
+                auto loss = policy_loss + value_loss;
+
+                loss.backward();
+
+                rl::torchutils::ExecutionUnitOutput out{0, 2};
+                out.scalars[0] = policy_loss.detach();
+                out.scalars[1] = value_loss.detach();
+
+                return out;
+            }
+
+        private:
+            std::shared_ptr<modules::Base> module;
+    };
 }
 
 #endif /* RL_AGENTS_ALPHA_ZERO_TRAINER_IMPL_INFERENCE_UNIT_H_ */
@@ -0,0 +1,62 @@
+#include "gradient_reducer.h"
+
+#include <rl/torchutils/torchutils.h>
+
+
+namespace trainer_impl
+{
+    GradientReducer::GradientReducer(
+        std::shared_ptr<torch::optim::Optimizer> optimizer,
+        std::shared_ptr<std::mutex> optimizer_step_mtx,
+        int workers,
+        std::function<void()> on_step
+    ) :
+        optimizer{optimizer},
+        optimizer_step_mtx{optimizer_step_mtx},
+        workers{workers},
+        on_step{on_step}
+    {}
+
+    torch::Tensor GradientReducer::reduce_and_step()
+    {
+        std::unique_lock lock{mtx};
+        if (!running) {
+            return torch::Tensor{};
+        }
+
+        auto current_generation = generation;
+        arrived++;
+
+        if (arrived < workers) {
+            cv.wait(lock, [&] { return generation != current_generation || !running; });
+            return generation != current_generation ? gradient_norm : torch::Tensor{};
+        }
+
+        {
+            torch::NoGradGuard no_grad_guard{};
+            std::lock_guard optimizer_step_guard{*optimizer_step_mtx};
+
+            rl::torchutils::scale_gradients(optimizer, 1.0 / workers);
+            gradient_norm = rl::torchutils::compute_gradient_norm(optimizer);
+            optimizer->step();
+            optimizer->zero_grad();
+        }
+        if (on_step) {
+            on_step();
+        }
+
+        arrived = 0;
+        generation++;
+        cv.notify_all();
+        return gradient_norm;
+    }
+
+    void GradientReducer::stop()
+    {
+        {
+            std::lock_guard lock{mtx};
+            running = false;
+        }
+        cv.notify_all();
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef RL_AGENTS_ALPHA_ZERO_TRAINER_IMPL_GRADIENT_REDUCER_H_
+#define RL_AGENTS_ALPHA_ZERO_TRAINER_IMPL_GRADIENT_REDUCER_H_
+
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <torch/torch.h>
+
+
+namespace trainer_impl
+{
+    // Synchronous gradient all-reduce for data parallel training workers sharing
+    // one module. Workers accumulate gradients of their own batches into the
+    // shared parameters, after which the last worker to arrive averages them and
+    // applies a single optimizer step, followed by `on_step` if set.
+    class GradientReducer
+    {
+        public:
+            GradientReducer(
+                std::shared_ptr<torch::optim::Optimizer> optimizer,
+                std::shared_ptr<std::mutex> optimizer_step_mtx,
+                int workers,
+                std::function<void()> on_step=nullptr
+            );
+
+            // Blocks until all workers have accumulated their gradients and the
+            // optimizer has stepped. Returns the norm of the averaged gradient, or
+            // an undefined tensor if the reducer was stopped.
+            torch::Tensor reduce_and_step();
+
+            // Releases all waiting workers.
+            void stop();
+
+        private:
+            std::shared_ptr<torch::optim::Optimizer> optimizer;
+            std::shared_ptr<std::mutex> optimizer_step_mtx;
+            const int workers;
+            std::function<void()> on_step;
+
+            std::mutex mtx{};
+            std::condition_variable cv{};
+            int arrived{0};
+            int64_t generation{0};
+            bool running{true};
+            torch::Tensor gradient_norm;
+    };
+}
+
+#endif /* RL_AGENTS_ALPHA_ZERO_TRAINER_IMPL_GRADIENT_REDUCER_H_ */
@@ -25,9 +25,12 @@ namespace trainer_impl
         float temperature
     )
     {
+        // Roots searched with Gumbel search carry an improved policy, which is
+        // used in place of the visit counts.
         std::vector<torch::Tensor> visit_counts_vector{}; visit_counts_vector.reserve(nodes.size());
         for (const auto &node : nodes) {
-            visit_counts_vector.push_back(node->visit_count());
+            auto improved_policy = node->improved_policy();
+            visit_counts_vector.push_back(improved_policy.defined() ? improved_policy : node->visit_count());
         }
         auto visit_counts = torch::stack({visit_counts_vector}).to(torch::kFloat32);
         visit_counts.pow_(1.0f / temperature);
@@ -35,6 +38,16 @@ namespace trainer_impl
         return rl::policies::Categorical{visit_counts};
     }
 
+    inline
+    torch::Tensor mcts_nodes_to_selected_actions(const std::vector<std::shared_ptr<MCTSNode>> &nodes)
+    {
+        std::vector<int64_t> actions{}; actions.reserve(nodes.size());
+        for (const auto &node : nodes) {
+            actions.push_back(node->selected_action());
+        }
+        return torch::tensor(actions, torch::TensorOptions{}.dtype(torch::kLong));
+    }
+
     inline
     std::vector<c10::Stream> get_cuda_streams()
     {
@@ -0,0 +1,128 @@
+#include "inference_server.h"
+
+#include <chrono>
+
+
+namespace trainer_impl
+{
+    InferenceServer::InferenceServer(
+        std::shared_ptr<modules::Base> module,
+        const InferenceServerOptions &options
+    ) :
+        module{module},
+        options{options}
+    {
+        inference_unit = std::make_unique<InferenceUnit>(
+            options.max_batchsize,
+            options.module_device,
+            module,
+            options.enable_cuda_graph_inference
+        );
+    }
+
+    void InferenceServer::start()
+    {
+        running = true;
+        working_thread = std::thread(&InferenceServer::worker, this);
+    }
+
+    void InferenceServer::stop()
+    {
+        running = false;
+        cv.notify_all();
+        if (working_thread.joinable()) {
+            working_thread.join();
+        }
+    }
+
+    MCTSInferenceResult InferenceServer::infer(const torch::Tensor &states)
+    {
+        if (states.size(0) > options.max_batchsize) {
+            throw std::invalid_argument{
+                "Cannot infer a batch larger than the server batchsize. Received "
+                "batch of size " + std::to_string(states.size(0)) + ", configured max "
+                "batchsize is " + std::to_string(options.max_batchsize) + "."
+            };
+        }
+
+        auto request = std::make_shared<Request>();
+        request->states = states;
+        auto result = request->result.get_future();
+
+        {
+            std::lock_guard lock{mtx};
+            requests.push_back(request);
+            queued_states += states.size(0);
+        }
+        cv.notify_all();
+
+        auto outputs = result.get();
+        return MCTSInferenceResult{outputs.tensors[0], outputs.tensors[1]};
+    }
+
+    void InferenceServer::worker()
+    {
+        while (running)
+        {
+            std::vector<std::shared_ptr<Request>> batch{};
+
+            {
+                std::unique_lock lock{mtx};
+                if (!cv.wait_for(lock, std::chrono::milliseconds(500), [this] () { return !requests.empty(); })) {
+                    continue;
+                }
+
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.max_delay_ms);
+                cv.wait_until(lock, deadline, [this] () { return queued_states >= options.max_batchsize || !running; });
+
+                int64_t size{0};
+                while (!requests.empty() && size + requests.front()->states.size(0) <= options.max_batchsize)
+                {
+                    size += requests.front()->states.size(0);
+                    batch.push_back(requests.front());
+                    requests.pop_front();
+                }
+                queued_states -= size;
+            }
+
+            execute(batch);
+        }
+    }
+
+    void InferenceServer::execute(const std::vector<std::shared_ptr<Request>> &batch)
+    {
+        try
+        {
+            std::vector<torch::Tensor> states{}; states.reserve(batch.size());
+            for (const auto &request : batch) {
+                states.push_back(request->states.to(options.module_device));
+            }
+
+            auto outputs = inference_unit->operator()({torch::cat(states)});
+
+            int64_t offset{0};
+            for (const auto &request : batch)
+            {
+                auto n = request->states.size(0);
+                rl::torchutils::ExecutionUnitOutput out{2, 0};
+                out.tensors[0] = outputs.tensors[0].narrow(0, offset, n);
+                out.tensors[1] = outputs.tensors[1].narrow(0, offset, n);
+                request->result.set_value(out);
+                offset += n;
+            }
+
+            if (options.logger) {
+                options.logger->log_scalar("AlphaZero/Shared inference batch size", offset);
+                options.logger->log_scalar("AlphaZero/Shared inference requests", batch.size());
+            }
+        }
+        catch (...)
+        {
+            for (const auto &request : batch) {
+                try {
+                    request->result.set_exception(std::current_exception());
+                } catch (const std::future_error &) {}
+            }
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef RL_AGENTS_ALPHA_ZERO_TRAINER_IMPL_INFERENCE_SERVER_H_
+#define RL_AGENTS_ALPHA_ZERO_TRAINER_IMPL_INFERENCE_SERVER_H_
+
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <torch/torch.h>
+
+#include <rl/option.h>
+#include <rl/logging/client/base.h>
+#include <rl/agents/alpha_zero/alpha_zero.h>
+#include <rl/torchutils/execution_unit.h>
+
+#include "execution_units.h"
+
+
+using namespace rl::agents::alpha_zero;
+
+namespace trainer_impl
+{
+    struct InferenceServerOptions
+    {
+        RL_OPTION(int, max_batchsize) = 128;
+        RL_OPTION(int, max_delay_ms) = 5;
+
+        RL_OPTION(torch::Device, module_device) = torch::kCPU;
+        RL_OPTION(bool, enable_cuda_graph_inference) = true;
+
+        RL_OPTION(std::shared_ptr<rl::logging::client::Base>, logger) = nullptr;
+    };
+
+    // Merges inference requests from several threads into shared batches, executed
+    // once `max_batchsize` states are queued or the oldest request has waited
+    // `max_delay_ms`.
+    class InferenceServer
+    {
+        public:
+            InferenceServer(
+                std::shared_ptr<modules::Base> module,
+                const InferenceServerOptions &options={}
+            );
+
+            void start();
+            void stop();
+
+            // Blocks until the batch containing `states` has been executed.
+            MCTSInferenceResult infer(const torch::Tensor &states);
+
+        private:
+            struct Request
+            {
+                torch::Tensor states;
+                std::promise<rl::torchutils::ExecutionUnitOutput> result;
+            };
+
+            std::shared_ptr<modules::Base> module;
+            const InferenceServerOptions options;
+            std::unique_ptr<InferenceUnit> inference_unit;
+
+            std::atomic<bool> running{false};
+            std::thread working_thread;
+
+            std::mutex mtx{};
+            std::condition_variable cv{};
+            std::deque<std::shared_ptr<Request>> requests{};
+            int64_t queued_states{0};
+
+        private:
+            void worker();
+            void execute(const std::vector<std::shared_ptr<Request>> &batch);
+    };
+}
+
+#endif /* RL_AGENTS_ALPHA_ZERO_TRAINER_IMPL_INFERENCE_SERVER_H_ */
@@ -1,6 +1,10 @@
 #include "self_play_worker.h"
 
+#include <algorithm>
+
 #include <rl/utils/reward/backpropagate.h>
+#include <rl/cpputils/concat_vector.h>
+#include <rl/cpputils/slice_vector.h>
 
 #include "helpers.h"
 
@@ -57,6 +61,7 @@ namespace trainer_impl
         mask_history.index_put_({terminal_indices, 0}, masks);
         mask_history.index_put_({terminal_indices, Slice(1, None)}, false);
         action_history.index_put_({terminal_indices}, 0l);
+        policy_history.index_put_({terminal_indices}, 0.0f);
         reward_history.index_put_({terminal_mask}, torch::zeros_like(reward_history.index({terminal_mask})));
         steps.index_put_({terminal_mask}, 0);
     }
@@ -68,7 +73,10 @@ namespace trainer_impl
         auto states = this->state_history.index({terminal_mask}).index({Slice(), 0});
         auto masks = this->mask_history.index({terminal_mask}).index({Slice(), 0});
 
-        auto output = inference_fn(states.to(options.module_device));
+        auto &evaluation_cache = options.mcts_options.evaluation_cache;
+        auto output = evaluation_cache
+            ? evaluation_cache->evaluate(states, inference_fn_var, options.module_device)
+            : inference_fn(states.to(options.module_device));
         auto priors = output.policies.get_probabilities().to(torch::kCPU);
         auto values = output.values.to(torch::kCPU);
         
@@ -84,7 +92,8 @@ namespace trainer_impl
                 states.index({j}),
                 masks.index({j}),
                 priors.index({j}),
-                values.index({j}).item().toFloat()
+                values.index({j}).item().toFloat(),
+                options.mcts_options
             );
         }
 
@@ -102,30 +111,21 @@ namespace trainer_impl
 
         mcts_nodes.resize(options.batchsize);
 
-        state_history = states.unsqueeze(1);
-        mask_history = masks.unsqueeze(1);
-
-        for (int i = 0; i < options.max_episode_length - 1; i++)
-        {
-            state_history = torch::concat(
-                {
-                    state_history,
-                    torch::zeros_like(states).unsqueeze(1)
-                },
-                1
-            );
-
-            mask_history = torch::concat(
-                {
-                    mask_history,
-                    torch::zeros_like(masks).unsqueeze(1)
-                },
-                1
-            );
-        }
+        std::vector<int64_t> history_shape{options.batchsize, options.max_episode_length};
+        state_history = torch::zeros(
+            rl::cpputils::concat(history_shape, rl::cpputils::slice(states.sizes().vec(), 1, states.dim())),
+            states.options()
+        );
+        mask_history = torch::zeros(
+            rl::cpputils::concat(history_shape, rl::cpputils::slice(masks.sizes().vec(), 1, masks.dim())),
+            masks.options()
+        );
+        state_history.index_put_({Slice(), 0}, states);
+        mask_history.index_put_({Slice(), 0}, masks);
 
         reward_history = torch::zeros({options.batchsize, options.max_episode_length});
         action_history = torch::zeros({options.batchsize, options.max_episode_length}, torch::TensorOptions{}.dtype(torch::kLong));
+        policy_history = torch::zeros({options.batchsize, options.max_episode_length, masks.size(1)});
         steps = torch::zeros({options.batchsize}, torch::TensorOptions{}.dtype(torch::kLong));
 
         reset_mcts_nodes(torch::ones({options.batchsize}, torch::TensorOptions{}.dtype(torch::kBool)));
@@ -172,11 +172,24 @@ namespace trainer_impl
         return terminals;
     }
 
+    void SelfPlayWorker::record_policies()
+    {
+        auto policies = mcts_nodes_to_policy(mcts_nodes, 1.0f).get_probabilities();
+        policy_history.index_put_({batchvec, steps}, policies);
+    }
+
     void SelfPlayWorker::step()
     {
         mcts(&mcts_nodes, inference_fn_var, simulator, options.mcts_options);
-        auto policy = mcts_nodes_to_policy(mcts_nodes, options.temperature_control->get());
-        auto actions = policy.sample();
+        record_policies();
+        torch::Tensor actions;
+        if (options.mcts_options.gumbel) {
+            actions = mcts_nodes_to_selected_actions(mcts_nodes);
+        }
+        else {
+            auto policy = mcts_nodes_to_policy(mcts_nodes, options.temperature_control->get());
+            actions = policy.sample();
+        }
         auto terminals = step_mcts_nodes(actions);
 
         if (terminals.any().item().toBool()) {
@@ -202,6 +215,7 @@ namespace trainer_impl
         auto states = this->state_history.index({terminal_mask});
         auto masks = this->mask_history.index({terminal_mask});
         auto actions = this->action_history.index({terminal_mask});
+        auto policies = this->policy_history.index({terminal_mask});
         auto rewards = this->reward_history.index({terminal_mask});
 
         auto max_length = steps.max().item().toLong();
@@ -213,39 +227,19 @@ namespace trainer_impl
 
         auto batchsize = steps.size(0);
 
-        for (int i = 0; i < batchsize; i++)
-        {
-            auto episode_length = steps.index({i}).item().toLong();
-            SelfPlayEpisode episode{};
-            episode.states = states.index({i, Slice(None, episode_length)});
-            episode.masks = masks.index({i, Slice(None, episode_length)});
-            episode.actions = actions.index({i, Slice(None, episode_length)});
-            episode.collected_rewards = G.index({i, Slice(None, episode_length)});
-
-            enqueue_episode(episode);
-
-            if (options.hindsight_callback) {
-                SelfPlayEpisode hindsight_episode{};
-                hindsight_episode.states = episode.states.clone();
-                hindsight_episode.masks = episode.masks.clone();
-                hindsight_episode.actions = episode.actions.clone();
-                hindsight_episode.collected_rewards = episode.collected_rewards.clone();
-                auto should_enqueue = options.hindsight_callback(&hindsight_episode);
-
-                if (should_enqueue) {
-                    enqueue_episode(hindsight_episode);
-
-                    if (options.logger) {
-                        options.logger->log_scalar(
-                            "AlphaZero/Hindsight reward",
-                            hindsight_episode.collected_rewards.index({0}).item().toFloat()
-                        );
-                        options.logger->log_frequency(
-                            "AlphaZero/Hindsight episode rate", 1
-                        );
-                    }
-                }
-            }
+        // All finished episodes are moved to the replay as one batch of steps.
+        auto valid_steps = torch::arange(max_length).unsqueeze(0) < steps.unsqueeze(1);
+        SelfPlayEpisode episodes{};
+        episodes.states = states.index({Slice(), Slice(None, max_length)}).index({valid_steps});
+        episodes.masks = masks.index({Slice(), Slice(None, max_length)}).index({valid_steps});
+        episodes.actions = actions.index({Slice(), Slice(None, max_length)}).index({valid_steps});
+        episodes.policies = policies.index({Slice(), Slice(None, max_length)}).index({valid_steps});
+        episodes.collected_rewards = G.index({valid_steps});
+        episodes.reanalyse = torch::zeros({episodes.states.size(0)}, torch::TensorOptions{}.dtype(torch::kBool));
+        enqueue_episode(episodes);
+
+        if (options.hindsight_callback) {
+            process_hindsight(steps, states, masks, actions, policies, G);
         }
 
         if (options.logger) {
@@ -255,6 +249,69 @@ namespace trainer_impl
         }
     }
 
+    void SelfPlayWorker::process_hindsight(
+        const torch::Tensor &steps,
+        const torch::Tensor &states,
+        const torch::Tensor &masks,
+        const torch::Tensor &actions,
+        const torch::Tensor &policies,
+        const torch::Tensor &G
+    )
+    {
+        auto steps_accessor = steps.accessor<int64_t, 1>();
+        std::vector<SelfPlayEpisode> hindsight_episodes{};
+
+        for (int i = 0; i < steps.size(0); i++)
+        {
+            auto episode_length = steps_accessor[i];
+            SelfPlayEpisode hindsight_episode{};
+            hindsight_episode.states = states.index({i, Slice(None, episode_length)}).clone();
+            hindsight_episode.masks = masks.index({i, Slice(None, episode_length)}).clone();
+            hindsight_episode.actions = actions.index({i, Slice(None, episode_length)}).clone();
+            hindsight_episode.policies = policies.index({i, Slice(None, episode_length)}).clone();
+            hindsight_episode.collected_rewards = G.index({i, Slice(None, episode_length)}).clone();
+            auto should_enqueue = options.hindsight_callback(&hindsight_episode);
+
+            if (!should_enqueue) {
+                continue;
+            }
+
+            if (options.logger) {
+                options.logger->log_scalar(
+                    "AlphaZero/Hindsight reward",
+                    hindsight_episode.collected_rewards.index({0}).item().toFloat()
+                );
+                options.logger->log_frequency(
+                    "AlphaZero/Hindsight episode rate", 1
+                );
+            }
+            hindsight_episodes.push_back(std::move(hindsight_episode));
+        }
+
+        if (hindsight_episodes.empty()) {
+            return;
+        }
+
+        std::vector<torch::Tensor> episode_states{}, episode_masks{}, episode_actions{}, episode_policies{}, episode_rewards{};
+        for (const auto &episode : hindsight_episodes) {
+            episode_states.push_back(episode.states);
+            episode_masks.push_back(episode.masks);
+            episode_actions.push_back(episode.actions);
+            episode_policies.push_back(episode.policies);
+            episode_rewards.push_back(episode.collected_rewards);
+        }
+
+        SelfPlayEpisode episodes{};
+        episodes.states = torch::cat(episode_states);
+        episodes.masks = torch::cat(episode_masks);
+        episodes.actions = torch::cat(episode_actions);
+        episodes.policies = torch::cat(episode_policies);
+        episodes.collected_rewards = torch::cat(episode_rewards);
+        // Relabeled states were never searched, their stored policies are stale.
+        episodes.reanalyse = torch::ones({episodes.states.size(0)}, torch::TensorOptions{}.dtype(torch::kBool));
+        enqueue_episode(episodes);
+    }
+
     void SelfPlayWorker::enqueue_episode(const SelfPlayEpisode &episode)
     {
         bool enqueued{false};
@@ -265,8 +322,12 @@ namespace trainer_impl
 
     void SelfPlayWorker::setup_inference_unit()
     {
+        if (options.inference_server) {
+            return;
+        }
+
         inference_unit = std::make_unique<InferenceUnit>(
-            options.batchsize,
+            std::max<int64_t>(options.batchsize, options.mcts_options.max_inference_batchsize),
             options.module_device,
             module,
             options.enable_cuda_graph_inference
@@ -275,6 +336,10 @@ namespace trainer_impl
     }
 
     MCTSInferenceResult SelfPlayWorker::inference_fn(const torch::Tensor &states) {
+        if (options.inference_server) {
+            return options.inference_server->infer(states);
+        }
+
         auto outputs = inference_unit->operator()({states});
         return MCTSInferenceResult{
             outputs.tensors[0],
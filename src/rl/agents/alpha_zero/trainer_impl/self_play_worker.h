@@ -22,6 +22,7 @@
 
 #include "result_tracker.h"
 #include "execution_units.h"
+#include "inference_server.h"
 
 
 using namespace rl::agents::alpha_zero;
@@ -39,6 +40,10 @@ namespace trainer_impl
         RL_OPTION(torch::Device, module_device) = torch::kCPU;
         RL_OPTION(bool, enable_cuda_graph_inference) = true;
 
+        // If set, inference requests are sent to the shared server instead of a
+        // private inference unit.
+        RL_OPTION(std::shared_ptr<InferenceServer>, inference_server) = nullptr;
+
         RL_OPTION(std::shared_ptr<rl::logging::client::Base>, logger) = nullptr;
         RL_OPTION(std::function<bool(SelfPlayEpisode*)>, hindsight_callback) = nullptr;
     };
@@ -76,6 +81,7 @@ namespace trainer_impl
             torch::Tensor state_history;
             torch::Tensor mask_history;
             torch::Tensor action_history;
+            torch::Tensor policy_history;
             torch::Tensor reward_history;
             torch::Tensor steps;
 
@@ -83,10 +89,19 @@ namespace trainer_impl
             void worker();
             void step();
             torch::Tensor step_mcts_nodes(const torch::Tensor &actions);
+            void record_policies();
             void set_initial_state();
             void reset_mcts_nodes(const torch::Tensor &terminal_mask);
             void reset_histories(const torch::Tensor &terminal_mask);
             void process_terminals(const torch::Tensor &terminal_mask);
+            void process_hindsight(
+                const torch::Tensor &steps,
+                const torch::Tensor &states,
+                const torch::Tensor &masks,
+                const torch::Tensor &actions,
+                const torch::Tensor &policies,
+                const torch::Tensor &G
+            );
             void enqueue_episode(const SelfPlayEpisode &episode);
 
             void setup_inference_unit();
@@ -1,5 +1,7 @@
 #include "trainer.h"
 
+#include <algorithm>
+
 #include <c10/cuda/CUDAStream.h>
 #include <rl/torchutils/torchutils.h>
 
@@ -54,18 +56,22 @@ namespace trainer_impl
     torch::Tensor Trainer::get_target_policy(const torch::Tensor &states, const torch::Tensor &masks)
     {
         torch::NoGradGuard no_grad_guard{};
-        auto inference_output = inference_fn(states.to(options.module_device));
+        auto &evaluation_cache = options.mcts_options.evaluation_cache;
+        auto inference_output = evaluation_cache
+            ? evaluation_cache->evaluate(states, inference_fn_var, options.module_device)
+            : inference_fn(states.to(options.module_device));
         auto priors = inference_output.policies.get_probabilities().to(torch::kCPU);
         auto values = inference_output.values.to(torch::kCPU);
 
-        std::vector<std::shared_ptr<MCTSNode>> nodes{}; nodes.reserve(options.batchsize);
-        for (int i = 0; i < options.batchsize; i++) {
+        std::vector<std::shared_ptr<MCTSNode>> nodes{}; nodes.reserve(states.size(0));
+        for (int i = 0; i < states.size(0); i++) {
             nodes.push_back(
                 std::make_shared<MCTSNode>(
                     states.index({i}),
                     masks.index({i}),
                     priors.index({i}),
-                    values.index({i}).item().toFloat()
+                    values.index({i}).item().toFloat(),
+                    options.mcts_options
                 )
             );
         }
@@ -82,12 +88,45 @@ namespace trainer_impl
         auto &states = sample[0];
         auto &masks = sample[1];
         auto &rewards = sample[2];
+        auto &policies = sample[3];
+        auto &reanalyse = sample[4];
+
+        auto temperature = options.temperature_control->get();
+        auto posteriors = rl::policies::Categorical{policies.pow(1.0f / temperature)}.get_probabilities();
+
+        // Samples are drawn at random, hence the first ones may be reanalysed.
+        // Samples flagged in the replay, i.e. relabeled in hindsight, are always
+        // reanalysed.
+        auto reanalyse_count = static_cast<int64_t>(std::round(options.reanalyse_fraction * options.batchsize));
+        auto reanalyse_mask = reanalyse.to(torch::kCPU).clone();
+        reanalyse_mask.index_put_({Slice(None, reanalyse_count)}, true);
+        auto reanalyse_indices = reanalyse_mask.nonzero().squeeze(-1);
+        if (reanalyse_indices.size(0) > 0) {
+            auto reanalysed = get_target_policy(
+                states.index({reanalyse_indices.to(states.device())}),
+                masks.index({reanalyse_indices.to(masks.device())})
+            );
+            posteriors.index_put_({reanalyse_indices.to(posteriors.device())}, reanalysed.to(posteriors.device()));
+        }
 
-        auto posteriors = get_target_policy(states, masks);
-
-        std::unique_lock optimizer_step_guard{*optimizer_step_mtx};
-        auto training_outputs = training_unit->operator()({states.to(options.module_device), posteriors.to(options.module_device), rewards.to(options.module_device)});
-        optimizer_step_guard.unlock();
+        rl::torchutils::ExecutionUnitOutput training_outputs{};
+        if (options.gradient_reducer) {
+            training_outputs = gradient_unit->operator()({states.to(options.module_device), posteriors.to(options.module_device), rewards.to(options.module_device)});
+            auto gradient_norm = options.gradient_reducer->reduce_and_step();
+            if (!gradient_norm.defined()) {
+                return;
+            }
+            training_outputs.scalars.push_back(gradient_norm);
+        }
+        else {
+            std::unique_lock optimizer_step_guard{*optimizer_step_mtx};
+            training_outputs = training_unit->operator()({states.to(options.module_device), posteriors.to(options.module_device), rewards.to(options.module_device)});
+            optimizer_step_guard.unlock();
+
+            if (options.on_optimizer_step) {
+                options.on_optimizer_step();
+            }
+        }
 
         if (options.logger)
         {
@@ -100,8 +139,12 @@ namespace trainer_impl
 
     void Trainer::setup_inference_unit()
     {
+        if (options.inference_server) {
+            return;
+        }
+
         inference_unit = std::make_unique<InferenceUnit>(
-            options.batchsize,
+            std::max<int64_t>(options.batchsize, options.mcts_options.max_inference_batchsize),
             options.module_device,
             module,
             options.enable_cuda_graph_inference
@@ -110,6 +153,10 @@ namespace trainer_impl
     }
 
     MCTSInferenceResult Trainer::inference_fn(const torch::Tensor &states) {
+        if (options.inference_server) {
+            return options.inference_server->infer(states);
+        }
+
         auto outputs = inference_unit->operator()({states});
         return MCTSInferenceResult{
             outputs.tensors[0],
@@ -119,7 +166,17 @@ namespace trainer_impl
 
     void Trainer::setup_training_unit()
     {
-                training_unit = std::make_unique<TrainingUnit>(
+        if (options.gradient_reducer) {
+            gradient_unit = std::make_unique<GradientUnit>(
+                options.batchsize,
+                options.module_device,
+                module,
+                options.enable_cuda_graph_training
+            );
+            return;
+        }
+
+        training_unit = std::make_unique<TrainingUnit>(
             options.batchsize,
             options.module_device,
             module,
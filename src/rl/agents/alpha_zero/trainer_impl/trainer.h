@@ -3,6 +3,7 @@
 
 
 #include <atomic>
+#include <functional>
 #include <mutex>
 #include <thread>
 
@@ -18,6 +19,8 @@
 #include <rl/torchutils/execution_unit.h>
 
 #include "execution_units.h"
+#include "inference_server.h"
+#include "gradient_reducer.h"
 
 
 using namespace rl::agents::alpha_zero;
@@ -32,11 +35,24 @@ namespace trainer_impl
         RL_OPTION(float, gradient_norm) = 40.0f;
         RL_OPTION(size_t, min_replay_size) = 1000;
         RL_OPTION(MCTSOptions, mcts_options) = MCTSOptions{};
+        // Fraction of each batch whose target policy is searched again.
+        RL_OPTION(float, reanalyse_fraction) = 0.0f;
+        // Called after each optimizer step taken by this trainer. Not called if
+        // `gradient_reducer` is set, in which case the reducer steps the optimizer.
+        RL_OPTION(std::function<void()>, on_optimizer_step) = nullptr;
 
         RL_OPTION(torch::Device, module_device) = torch::kCPU;
         RL_OPTION(bool, enable_cuda_graph_training) = true;
         RL_OPTION(bool, enable_cuda_graph_inference) = true;
 
+        // If set, inference requests are sent to the shared server instead of a
+        // private inference unit.
+        RL_OPTION(std::shared_ptr<InferenceServer>, inference_server) = nullptr;
+        // If set, gradients are reduced across workers and the optimizer is
+        // stepped by the reducer, instead of by each worker under the optimizer
+        // mutex.
+        RL_OPTION(std::shared_ptr<GradientReducer>, gradient_reducer) = nullptr;
+
         RL_OPTION(std::shared_ptr<rl::logging::client::Base>, logger) = nullptr;
     };
 
@@ -70,6 +86,7 @@ namespace trainer_impl
             std::function<MCTSInferenceResult(const torch::Tensor &)> inference_fn_var = std::bind(&Trainer::inference_fn, this, std::placeholders::_1);
             std::unique_ptr<InferenceUnit> inference_unit;
             std::unique_ptr<TrainingUnit> training_unit;
+            std::unique_ptr<GradientUnit> gradient_unit;
 
         private:
             void init_buffer();
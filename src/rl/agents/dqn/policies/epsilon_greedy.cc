@@ -23,4 +23,18 @@ namespace rl::agents::dqn::policies
 
         return std::make_unique<rl::policies::Categorical>(probabilities);
     }
+
+    torch::Tensor EpsilonGreedy::sample_actions(
+        const torch::Tensor &values,
+        const torch::Tensor &masks
+    )
+    {
+        auto epsilon = this->epsilon->get();
+
+        auto greedy_actions = values.where(masks, torch::zeros_like(values) - INFINITY).argmax(-1);
+        auto random_actions = sample_uniform_actions(masks);
+        auto explore = torch::rand(greedy_actions.sizes(), torch::TensorOptions{}.device(values.device())) < epsilon;
+
+        return torch::where(explore, random_actions, greedy_actions);
+    }
 }
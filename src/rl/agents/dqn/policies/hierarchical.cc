@@ -12,6 +12,39 @@ namespace rl::agents::dqn::policies {
             sub_policy_probabilities[i] = policies[i]->policy(values, masks)->get_probabilities();
         }
 
+        auto probabilities = get_probabilities();
+
+        return std::make_unique<rl::policies::Categorical>(
+            torch::sum(
+                torch::stack(sub_policy_probabilities, 1) *
+                torch::tensor(probabilities, sub_policy_probabilities[0].options()).view({1, -1, 1}),
+                1
+            )
+        );
+    }
+
+    torch::Tensor Hierarchical::sample_actions(
+        const torch::Tensor &values,
+        const torch::Tensor &masks
+    ) {
+        // Sub policy samples are cheap compared to materializing their distributions,
+        // hence each is sampled for all rows and one is picked per row.
+        std::vector<torch::Tensor> sub_policy_actions{}; sub_policy_actions.resize(policies.size());
+        for (int i = 0; i < policies.size(); i++) {
+            sub_policy_actions[i] = policies[i]->sample_actions(values, masks);
+        }
+
+        auto selected_policies = torch::multinomial(
+            torch::tensor(get_probabilities(), torch::TensorOptions{}.device(values.device())),
+            values.size(0),
+            true
+        );
+
+        return torch::stack(sub_policy_actions, 1).gather(1, selected_policies.unsqueeze(1)).squeeze(1);
+    }
+
+    std::vector<float> Hierarchical::get_probabilities() const
+    {
         std::vector<float> probabilities{}; probabilities.resize(policies.size());
         float sum{0.0f};
         for (int i = 0; i < policies.size(); i++) {
@@ -21,13 +54,6 @@ namespace rl::agents::dqn::policies {
         for (int i = 0; i < policies.size(); i++) {
             probabilities[i] /= sum;
         }
-
-        return std::make_unique<rl::policies::Categorical>(
-            torch::sum(
-                torch::stack(sub_policy_probabilities, 1) *
-                torch::tensor(probabilities, sub_policy_probabilities[0].options()).view({1, -1, 1}),
-                1
-            )
-        );
+        return probabilities;
     }
 }
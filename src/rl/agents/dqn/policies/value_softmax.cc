@@ -11,4 +11,14 @@ namespace rl::agents::dqn::policies {
         auto probabilities = torch::softmax(masked_values / temperature->get(), -1);
         return std::make_unique<rl::policies::Categorical>(probabilities);
     }
+
+    torch::Tensor ValueSoftmax::sample_actions(
+        const torch::Tensor &values,
+        const torch::Tensor &masks
+    ) {
+        // Gumbel-max, the argmax of perturbed logits is distributed as the softmax.
+        auto masked_values = values.where(masks, torch::zeros_like(values) - INFINITY);
+        auto gumbel_noise = -torch::empty_like(masked_values).exponential_().log();
+        return (masked_values / temperature->get() + gumbel_noise).argmax(-1);
+    }
 }
@@ -7,6 +7,7 @@
 #include <rl/torchutils/execution_unit.h>
 #include <rl/torchutils/gradient_norm.h>
 #include <rl/torchutils/scale_gradients.h>
+#include <rl/torchutils/target_update.h>
 #include <rl/agents/dqn/module.h>
 #include <rl/agents/dqn/value_parsers/base.h>
 #include <rl/agents/dqn/trainers/apex.h>
@@ -102,12 +103,8 @@ namespace rl::agents::dqn::trainers::apex_impl
 
                 // Revert training step just applied
                 torch::NoGradGuard guard{};
-                auto module_params = module->parameters();
-                auto target_module_params = target_module->parameters();
-                for (size_t i = 0; i < original_module_params.size(); i++) {
-                    module_params[i].copy_(original_module_params[i]);
-                    target_module_params[i].copy_(original_target_module_params[i]);
-                }
+                rl::torchutils::hard_update(module->parameters(), original_module_params);
+                rl::torchutils::hard_update(target_module->parameters(), original_target_module_params);
                 for (auto &p : original_opt_state) {
                     opt_state[p.first] = std::move(p.second);
                 }
@@ -150,13 +147,7 @@ namespace rl::agents::dqn::trainers::apex_impl
                 loss = loss.mean();
                 optimizer->zero_grad();
                 loss.backward();
-                auto grad_norm = rl::torchutils::compute_gradient_norm(optimizer);
-                auto grad_norm_factor = torch::where(
-                    grad_norm > options.max_gradient_norm,
-                    options.max_gradient_norm / grad_norm,
-                    torch::ones_like(grad_norm)
-                );
-                rl::torchutils::scale_gradients(optimizer, grad_norm_factor);
+                auto grad_norm = rl::torchutils::clip_gradient_norm(optimizer, options.max_gradient_norm);
                 optimizer->step();
 
                 rl::torchutils::ExecutionUnitOutput out{0, 2};
@@ -165,12 +156,9 @@ namespace rl::agents::dqn::trainers::apex_impl
 
                 {
                     torch::InferenceMode guard{};
-                    auto target_parameters = target_module->parameters();
-                    auto parameters = module->parameters();
-
-                    for (int i = 0; i < parameters.size(); i++) {
-                        target_parameters[i].add_(parameters[i] - target_parameters[i], options.target_network_lr);
-                    }
+                    rl::torchutils::polyak_update(
+                        target_module->parameters(), module->parameters(), options.target_network_lr
+                    );
                 }
 
                 return out;
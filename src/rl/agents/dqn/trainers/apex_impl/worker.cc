@@ -1,6 +1,8 @@
 #include "worker.h"
 
-#include <c10/cuda/CUDAStream.h>
+#include <chrono>
+
+#include <c10/core/StreamGuard.h>
 #include <rl/cpputils/logger.h>
 
 #include "helpers.h"
@@ -34,6 +36,12 @@ namespace rl::agents::dqn::trainers::apex_impl
     void Worker::start()
     {
         running = true;
+        // The inference thread executes on the same stream as the worker.
+        stream = c10::cuda::getStreamFromPool();
+        if (options.pipelined_workers) {
+            inference_running = true;
+            inference_thread = std::thread(&Worker::inference_worker, this);
+        }
         working_thread = std::thread(&Worker::worker, this);
     }
 
@@ -41,84 +49,179 @@ namespace rl::agents::dqn::trainers::apex_impl
     {
         running = false;
         if (working_thread.joinable()) working_thread.join();
+
+        // The worker awaits all its requests before exiting, hence the queue
+        // is empty once it has been joined.
+        {
+            std::lock_guard lock{inference_mtx};
+            inference_running = false;
+        }
+        inference_cv.notify_one();
+        if (inference_thread.joinable()) inference_thread.join();
     }
 
     void Worker::worker()
     {
-        torch::StreamGuard stream_guard{c10::cuda::getStreamFromPool()};
+        torch::StreamGuard stream_guard{*stream};
         torch::InferenceMode inference_guard{};
 
         envs.reserve(options.worker_batchsize);
-        n_step_collectors.reserve(options.worker_batchsize);
         for (int i = 0; i < options.worker_batchsize; i++) {
             envs.push_back(env_factory->get());
-            n_step_collectors.emplace_back(options.n_step, options.discount);
+        }
+
+        // Environments are split into groups, stepped in lockstep within a group.
+        auto groups = options.pipelined_workers ? 2 : 1;
+        for (int g = 0; g <= groups; g++) {
+            bounds.push_back(g * options.worker_batchsize / groups);
+        }
+        for (int g = 0; g < groups; g++) {
+            n_step_collectors.push_back(
+                std::make_unique<rl::utils::reward::BatchedNStepCollector>(
+                    options.n_step, options.discount, bounds[g + 1] - bounds[g]
+                )
+            );
         }
 
         states.resize(options.worker_batchsize);
-        episodes.resize(options.worker_batchsize);
         for (int i = 0; i < options.worker_batchsize; i++) {
             states[i] = envs[i]->reset();
-            episodes[i].states.push_back(states[i]);
+        }
+
+        // Episodes are only tracked if they may be relabeled.
+        if (options.hindsight_replay_callback) {
+            episodes.resize(options.worker_batchsize);
+            for (int i = 0; i < options.worker_batchsize; i++) {
+                episodes[i].states.push_back(states[i]);
+            }
         }
 
         is_start_state.resize(options.worker_batchsize, 1);
 
         LOGGER->info("Starting worker");
-        while (running) {
-            step();
+        if (options.pipelined_workers) {
+            run_pipelined();
+        }
+        else {
+            while (running) {
+                auto batch = launch(0);
+                finish(0, &batch);
+            }
         }
         LOGGER->info("Stopping worker");
     }
 
-    void Worker::step()
+    void Worker::run_pipelined()
     {
+        // While one group is in inference, the other steps its environments.
+        auto batch = launch(0);
+        while (running) {
+            auto next_batch = launch(1);
+            finish(0, &batch);
+            batch = launch(0);
+            finish(1, &next_batch);
+        }
+        batch.values.wait();
+    }
+
+    void Worker::inference_worker()
+    {
+        torch::StreamGuard stream_guard{*stream};
+        torch::InferenceMode inference_guard{};
+
+        while (true)
+        {
+            std::packaged_task<torch::Tensor()> task{};
+            {
+                std::unique_lock lock{inference_mtx};
+                inference_cv.wait(lock, [this] () { return !inference_running || !inference_tasks.empty(); });
+                if (inference_tasks.empty()) {
+                    return;
+                }
+                task = std::move(inference_tasks.front());
+                inference_tasks.pop();
+            }
+            task();
+        }
+    }
+
+    Worker::Batch Worker::launch(int group)
+    {
+        auto begin = bounds[group];
+        auto end = bounds[group + 1];
+
         std::vector<torch::Tensor> states{};
-        states.resize(options.worker_batchsize);
+        states.resize(end - begin);
         std::vector<torch::Tensor> masks{};
-        masks.resize(options.worker_batchsize);
+        masks.resize(end - begin);
 
-        for (int i = 0; i < options.worker_batchsize; i++) {
-            states[i] = this->states[i]->state;
-            masks[i] = get_mask(*this->states[i]->action_constraint);
+        for (int i = begin; i < end; i++) {
+            states[i - begin] = this->states[i]->state;
+            masks[i - begin] = get_mask(*this->states[i]->action_constraint);
+        }
+
+        Batch batch{};
+        batch.states = torch::stack(states, 0);
+        batch.masks = torch::stack(masks, 0);
+        batch.network_masks = batch.masks.to(options.network_device);
+        auto network_states = batch.states.to(options.network_device);
+
+        if (!options.pipelined_workers) {
+            std::promise<torch::Tensor> values{};
+            values.set_value(inference_unit->operator()({network_states, batch.network_masks}).tensors[0]);
+            batch.values = values.get_future();
+            return batch;
         }
 
-        auto tstates = torch::stack(states, 0).to(options.network_device);
-        auto tmasks = torch::stack(masks, 0).to(options.network_device);
+        std::packaged_task<torch::Tensor()> task{
+            [this, network_states, network_masks = batch.network_masks] () {
+                return inference_unit->operator()({network_states, network_masks}).tensors[0];
+            }
+        };
+        batch.values = task.get_future();
+        {
+            std::lock_guard lock{inference_mtx};
+            inference_tasks.push(std::move(task));
+        }
+        inference_cv.notify_one();
+        return batch;
+    }
 
-        auto inference_output = inference_unit->operator()({tstates, tmasks});
-        auto &values = inference_output.tensors[0];
+    void Worker::finish(int group, Batch *batch)
+    {
+        auto begin = bounds[group];
+        auto end = bounds[group + 1];
 
-        auto policy = this->policy->policy(values, tmasks);
+        auto wait_start = std::chrono::high_resolution_clock::now();
+        auto values = batch->values.get();
+        auto wait_time = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - wait_start);
 
-        auto actions = policy->sample().to(options.environment_device);
+        auto actions = policy->sample_actions(values, batch->network_masks).to(options.environment_device);
+        auto rewards = torch::zeros({end - begin});
+        auto terminals = torch::zeros({end - begin}, torch::kBool);
+        auto rewards_accessor = rewards.accessor<float, 1>();
+        auto terminals_accessor = terminals.accessor<bool, 1>();
+        std::vector<rl::utils::reward::BatchedNStepCollectorTransitions> hindsight_transitions{};
 
-        for (int i = 0; i < options.worker_batchsize; i++)
+        for (int i = begin; i < end; i++)
         {
+            auto j = i - begin;
             if (is_start_state[i]) {
                 is_start_state[i] = 0;
                 if (options.logger) {
-                    auto max_value = values.index({i}).max().item().toFloat();
-                    auto min_value = values.index({i}).where(~values.isneginf(), max_value).min().item().toFloat();
+                    auto max_value = values.index({j}).max().item().toFloat();
+                    auto min_value = values.index({j}).where(~values.isneginf(), max_value).min().item().toFloat();
                     options.logger->log_scalar("ApexDQN/StartValue", max_value);
                     options.logger->log_scalar("ApexDQN/StartAdvantage", max_value - min_value);
                 }
             }
 
-            auto action = actions.index({i});
+            auto action = actions.index({j});
 
             auto observation = envs[i]->step(action);
 
-            auto transitions = n_step_collectors[i].step(
-                this->states[i],
-                actions.index({i}),
-                observation->reward,
-                observation->terminal
-            );
-
-            for (const auto &transition : transitions) {
-                parse_transition(transition);
-            }
+            rewards_accessor[j] = observation->reward;
+            terminals_accessor[j] = observation->terminal;
 
             if (observation->terminal) {
                 this->states[i] = envs[i]->reset();
@@ -136,38 +239,101 @@ namespace rl::agents::dqn::trainers::apex_impl
                 this->states[i] = observation->state;
             }
 
+            if (!options.hindsight_replay_callback) {
+                continue;
+            }
+
             episodes[i].rewards.push_back(observation->reward);
             episodes[i].actions.push_back(action);
             episodes[i].states.push_back(observation->state);
 
             if (observation->terminal) {
-                if (options.hindsight_replay_callback) {
-                    auto add_to_buffer = options.hindsight_replay_callback(&episodes[i]);
-                    if (add_to_buffer) {
-                        throw std::runtime_error{"Adding to replay not yet supported."};
-                    }
+                auto add_to_buffer = options.hindsight_replay_callback(&episodes[i]);
+                if (add_to_buffer) {
+                    hindsight_transitions.push_back(
+                        rl::agents::dqn::utils::episode_to_n_step_transitions(
+                            episodes[i], options.n_step, options.discount
+                        )
+                    );
                 }
                 episodes[i] = rl::agents::dqn::utils::HindsightReplayEpisode{};
                 episodes[i].states.push_back(this->states[i]);
             }
         }
 
+        if (!hindsight_transitions.empty()) {
+            add_transitions(concat_transitions(hindsight_transitions));
+            if (options.logger) {
+                options.logger->log_frequency("ApexDQN/Hindsight episode rate", hindsight_transitions.size());
+            }
+        }
+
+        add_transitions(
+            n_step_collectors[group]->step(
+                {batch->states, batch->masks},
+                actions.to(batch->states.device()),
+                rewards.to(batch->states.device()),
+                terminals.to(batch->states.device())
+            )
+        );
+
         if (options.logger) {
-            options.logger->log_frequency("ApexDQN/Inference step rate", options.worker_batchsize);
+            options.logger->log_frequency("ApexDQN/Inference step rate", end - begin);
+            options.logger->log_scalar("ApexDQN/Inference wait seconds", wait_time.count());
+        }
+    }
+
+    rl::utils::reward::BatchedNStepCollectorTransitions Worker::concat_transitions(
+        const std::vector<rl::utils::reward::BatchedNStepCollectorTransitions> &transitions
+    )
+    {
+        std::vector<torch::Tensor> states{}, masks{}, actions{}, rewards{}, terminals{}, next_states{}, next_masks{};
+        for (const auto &x : transitions) {
+            states.push_back(x.states[0].to(options.replay_device));
+            masks.push_back(x.states[1].to(options.replay_device));
+            actions.push_back(x.actions.to(options.replay_device));
+            rewards.push_back(x.rewards.to(options.replay_device));
+            terminals.push_back(x.terminals.to(options.replay_device));
+            next_states.push_back(x.next_states[0].to(options.replay_device));
+            next_masks.push_back(x.next_states[1].to(options.replay_device));
         }
+
+        rl::utils::reward::BatchedNStepCollectorTransitions out{};
+        out.states = {torch::cat(states), torch::cat(masks)};
+        out.actions = torch::cat(actions);
+        out.rewards = torch::cat(rewards);
+        out.terminals = torch::cat(terminals);
+        out.next_states = {torch::cat(next_states), torch::cat(next_masks)};
+        return out;
     }
 
-    void Worker::parse_transition(const rl::utils::reward::NStepCollectorTransition &transition)
+    void Worker::add_transitions(const rl::utils::reward::BatchedNStepCollectorTransitions &transitions)
     {
-        local_buffer->add({
-            transition.state->state.to(options.replay_device).unsqueeze(0),
-            get_mask(*transition.state->action_constraint).to(options.replay_device).unsqueeze(0),
-            transition.action.to(options.replay_device).unsqueeze(0),
-            torch::tensor(transition.reward).to(options.replay_device).to(options.float_dtype).unsqueeze(0),
-            torch::tensor(!transition.terminal).to(options.replay_device).unsqueeze(0),
-            transition.next_state->state.to(options.replay_device).unsqueeze(0),
-            get_mask(*transition.next_state->action_constraint).to(options.replay_device).unsqueeze(0)
-        });
+        auto n = transitions.rewards.size(0);
+        if (n == 0) {
+            return;
+        }
+
+        std::vector<torch::Tensor> data{
+            transitions.states[0].to(options.replay_device),
+            transitions.states[1].to(options.replay_device),
+            transitions.actions.to(options.replay_device),
+            transitions.rewards.to(options.replay_device).to(options.float_dtype),
+            transitions.terminals.logical_not().to(options.replay_device),
+            transitions.next_states[0].to(options.replay_device),
+            transitions.next_states[1].to(options.replay_device)
+        };
+
+        if (n >= options.inference_replay_size) {
+            replay_buffer->add(data);
+            return;
+        }
+
+        if (local_buffer->size() + n > options.inference_replay_size) {
+            replay_buffer->add(*local_buffer->get(torch::arange(local_buffer->size())));
+            local_buffer->clear();
+        }
+        local_buffer->add(data);
 
         if (local_buffer->size() >= options.inference_replay_size) {
             replay_buffer->add(*local_buffer->get(torch::arange(options.inference_replay_size)));
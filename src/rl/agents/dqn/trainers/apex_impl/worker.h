@@ -4,13 +4,19 @@
 
 #include <thread>
 #include <atomic>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
 #include <vector>
+#include <condition_variable>
 
 #include <torch/torch.h>
+#include <c10/cuda/CUDAStream.h>
 
 #include <rl/agents/dqn/trainers/apex.h>
-#include <rl/utils/reward/n_step_collector.h>
+#include <rl/utils/reward/batched_n_step_collector.h>
 #include <rl/buffers/tensor.h>
 #include <rl/env/base.h>
 
@@ -45,17 +51,43 @@ namespace rl::agents::dqn::trainers::apex_impl
 
             std::atomic<bool> running{false};
             std::thread working_thread;
+            std::optional<c10::cuda::CUDAStream> stream{};
+
+            // Inference requests of pipelined workers, executed in order by
+            // the inference thread.
+            std::mutex inference_mtx{};
+            std::condition_variable inference_cv{};
+            std::queue<std::packaged_task<torch::Tensor()>> inference_tasks{};
+            bool inference_running{false};
+            std::thread inference_thread;
 
             std::vector<std::shared_ptr<rl::env::Base>> envs;
             std::vector<uint8_t> is_start_state;
             std::vector<rl::agents::dqn::utils::HindsightReplayEpisode> episodes;
-            std::vector<rl::utils::reward::NStepCollector> n_step_collectors;
+            std::vector<int64_t> bounds;
+            std::vector<std::unique_ptr<rl::utils::reward::BatchedNStepCollector>> n_step_collectors;
             std::vector<std::shared_ptr<rl::env::State>> states;
 
+        private:
+            // States of one group of environments, and their pending action values.
+            struct Batch
+            {
+                torch::Tensor states;
+                torch::Tensor masks;
+                torch::Tensor network_masks;
+                std::future<torch::Tensor> values;
+            };
+
         private:
             void worker();
-            void step();
-            void parse_transition(const rl::utils::reward::NStepCollectorTransition &transition);
+            void inference_worker();
+            void run_pipelined();
+            Batch launch(int group);
+            void finish(int group, Batch *batch);
+            rl::utils::reward::BatchedNStepCollectorTransitions concat_transitions(
+                const std::vector<rl::utils::reward::BatchedNStepCollectorTransitions> &transitions
+            );
+            void add_transitions(const rl::utils::reward::BatchedNStepCollectorTransitions &transitions);
     };
 }
 
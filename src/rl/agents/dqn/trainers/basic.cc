@@ -72,24 +72,12 @@ namespace rl::agents::dqn::trainers
                 loss = loss.mean();
                 optimizer->zero_grad();
                 loss.backward();
-                auto grad_norm = rl::torchutils::compute_gradient_norm(optimizer);
-                auto grad_norm_factor = torch::where(
-                    grad_norm > options.max_gradient_norm,
-                    options.max_gradient_norm / grad_norm,
-                    torch::ones_like(grad_norm)
-                );
-                rl::torchutils::scale_gradients(optimizer, grad_norm_factor);
+                auto grad_norm = rl::torchutils::clip_gradient_norm(optimizer, options.max_gradient_norm);
                 optimizer->step();
 
-                {
-                    torch::NoGradGuard guard{};
-                    auto target_parameters = target_module->parameters();
-                    auto parameters = module->parameters();
-
-                    for (int i = 0; i < parameters.size(); i++) {
-                        target_parameters[i].add_(parameters[i] - target_parameters[i], options.target_network_lr);
-                    }
-                }
+                rl::torchutils::polyak_update(
+                    target_module->parameters(), module->parameters(), options.target_network_lr
+                );
 
                 ExecutionUnitOutput out{0, 2};
                 out.scalars[0] = loss.detach();
@@ -149,7 +149,7 @@ namespace seed_impl
         auto outputs = module->forward(torch::stack(states).to(options->network_device));
         auto masks = torch::stack(this->masks).to(options->network_device);
         value = value_parser->values(outputs, masks);
-        actions = policy->policy(value, masks)->sample();
+        actions = policy->sample_actions(value, masks);
         advantage = std::get<0>(value.max(-1, true)) - value;
 
         executed_ = true;
@@ -97,13 +97,7 @@ namespace seed_impl
         loss = loss.mean();
         optimizer->zero_grad();
         loss.backward();
-        auto grad_norm = rl::torchutils::compute_gradient_norm(optimizer);
-        auto grad_norm_factor = torch::where(
-            grad_norm > options.max_gradient_norm,
-            options.max_gradient_norm / grad_norm,
-            torch::ones_like(grad_norm)
-        );
-        rl::torchutils::scale_gradients(optimizer, grad_norm_factor);
+        auto grad_norm = rl::torchutils::clip_gradient_norm(optimizer, options.max_gradient_norm);
         optimizer->step();
 
         if (options.logger) {
@@ -116,11 +110,8 @@ namespace seed_impl
     void Trainer::target_network_update()
     {
         torch::InferenceMode guard{};
-        auto target_parameters = target_module->parameters();
-        auto parameters = module->parameters();
-
-        for (int i = 0; i < parameters.size(); i++) {
-            target_parameters[i].add_(parameters[i] - target_parameters[i], options.target_network_lr);
-        }
+        rl::torchutils::polyak_update(
+            target_module->parameters(), module->parameters(), options.target_network_lr
+        );
     }
 }
@@ -1,7 +1,51 @@
 #include "rl/agents/dqn/utils/hindsight_replay.h"
 
+#include <rl/policies/constraints/categorical_mask.h>
+
+
+using namespace torch::indexing;
 
 namespace rl::agents::dqn::utils
 {
-    
+    rl::utils::reward::BatchedNStepCollectorTransitions episode_to_n_step_transitions(
+        const HindsightReplayEpisode &episode,
+        int n,
+        float discount
+    )
+    {
+        int64_t length = episode.actions.size();
+
+        std::vector<torch::Tensor> states{}, masks{};
+        states.reserve(length + 1);
+        masks.reserve(length + 1);
+        for (const auto &state : episode.states) {
+            states.push_back(state->state);
+            masks.push_back(
+                dynamic_cast<const rl::policies::constraints::CategoricalMask&>(*state->action_constraint).mask()
+            );
+        }
+        auto tstates = torch::stack(states);
+        auto tmasks = torch::stack(masks);
+
+        // Rewards are padded with n - 1 zeros, such that each window of n
+        // rewards covers the remainder of the episode.
+        auto rewards = torch::zeros({length + n - 1});
+        rewards.index_put_({Slice(None, length)}, torch::tensor(episode.rewards));
+        auto discounts = torch::pow(
+            torch::full({n}, discount),
+            torch::arange(n, torch::kFloat32)
+        );
+
+        auto steps = torch::arange(length);
+        auto next_steps = (steps + n).clamp_max(length);
+
+        rl::utils::reward::BatchedNStepCollectorTransitions out{};
+        out.states = {tstates.index({Slice(None, length)}), tmasks.index({Slice(None, length)})};
+        out.actions = torch::stack(episode.actions);
+        out.rewards = rewards.unfold(0, n, 1).matmul(discounts);
+        out.terminals = steps + n > length - 1;
+        out.next_states = {tstates.index({next_steps}), tmasks.index({next_steps})};
+
+        return out;
+    }
 }
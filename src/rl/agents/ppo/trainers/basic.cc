@@ -1,10 +1,12 @@
 #include "rl/agents/ppo/trainers/basic.h"
+#include "rl/agents/ppo/trainers/basic_rollouts.h"
 
 #include <thread>
 
 #include <thread_pool.hpp>
 
 #include "rl/policies/constraints/base.h"
+#include "rl/cpputils/concat_vector.h"
 #include "loss_fns.h"
 
 
@@ -69,26 +71,19 @@ namespace rl::agents::ppo::trainers
         }
     };
 
-    struct CompiledSequences {
-        torch::Tensor states{};
-        torch::Tensor actions{};
-        torch::Tensor rewards{};
-        torch::Tensor not_terminals{};
-        torch::Tensor action_probabilities{};
-        torch::Tensor state_values{};
-        std::shared_ptr<policies::constraints::Base> constraints{};
-
-        CompiledSequences(const Sequences &sequences)
-        {
-            states = torch::stack(sequences.states);
-            actions = torch::stack(sequences.actions);
-            rewards = torch::stack(sequences.rewards);
-            not_terminals = torch::stack(sequences.not_terminals);
-            action_probabilities = torch::stack(sequences.action_probabilities);
-            state_values = torch::stack(sequences.state_values);
-            constraints = rl::policies::constraints::stack(sequences.constraints);
-        }
-    };
+    static
+    std::unique_ptr<CompiledSequences> compile(const Sequences &sequences)
+    {
+        auto re = std::make_unique<CompiledSequences>();
+        re->states = torch::stack(sequences.states);
+        re->actions = torch::stack(sequences.actions);
+        re->rewards = torch::stack(sequences.rewards);
+        re->not_terminals = torch::stack(sequences.not_terminals);
+        re->action_probabilities = torch::stack(sequences.action_probabilities);
+        re->state_values = torch::stack(sequences.state_values);
+        re->constraints = rl::policies::constraints::stack(sequences.constraints);
+        return re;
+    }
 
     static
     void run_sequence(std::shared_ptr<env::Base> env, std::shared_ptr<agents::ppo::Module> model, const BasicOptions &options, Sequences *out, int out_i)
@@ -129,39 +124,109 @@ namespace rl::agents::ppo::trainers
         out->set(sequence, out_i);
     }
 
-    static
-    std::unique_ptr<Sequences> run_sequences(
+    std::unique_ptr<CompiledSequences> run_sequences(
         const std::vector<std::shared_ptr<env::Base>> &envs,
         std::shared_ptr<agents::ppo::Module> model,
         const BasicOptions &options,
         thread_pool &pool
     )
     {
-        auto re = std::make_unique<Sequences>(envs.size());
+        Sequences sequences{static_cast<int>(envs.size())};
 
         for (int i = 0; i < envs.size(); i++) {
-            pool.push_task(run_sequence, envs[i], model, options, re.get(), i);
+            pool.push_task(run_sequence, envs[i], model, options, &sequences, i);
         }
         pool.wait_for_tasks();
-        return re;
+        return compile(sequences);
     }
 
-    static
-    torch::Tensor loss_fn(const CompiledSequences &sequences, const std::shared_ptr<agents::ppo::Module> &model, const BasicOptions &options)
+    std::unique_ptr<CompiledSequences> run_lockstep_sequences(
+        const std::vector<std::shared_ptr<env::Base>> &envs,
+        std::shared_ptr<agents::ppo::Module> model,
+        const BasicOptions &options,
+        thread_pool &pool
+    )
     {
-        auto model_output = model->forward(sequences.states.index({Slice(), Slice(None, -1)}));
-        model_output->policy->include(sequences.constraints);
-        auto action_probabilities = model_output->policy->prob(sequences.actions);
+        torch::NoGradGuard no_grad{};
+        int64_t n = envs.size();
+        int64_t length = options.sequence_length;
+
+        auto re = std::make_unique<CompiledSequences>();
+        std::vector<std::shared_ptr<env::State>> states(n);
+        std::vector<uint8_t> was_reset(n, 0);
+        std::vector<std::vector<std::shared_ptr<policies::constraints::Base>>> constraints(n);
+        std::vector<float> rewards(n * length);
+        std::vector<uint8_t> not_terminals(n * length);
+
+        for (int64_t i = 0; i < n; i++) {
+            was_reset[i] = envs[i]->is_terminal();
+            states[i] = was_reset[i] ? envs[i]->reset() : envs[i]->state();
+            constraints[i].reserve(length);
+        }
 
-        auto last_state_output = model->forward(sequences.states.index({Slice(), Slice(-1, None)}));
-        auto values = torch::cat({model_output->value, last_state_output->value}, 1);
+        auto stack_states = [&] () {
+            std::vector<torch::Tensor> out{};
+            out.reserve(n);
+            for (int64_t i = 0; i < n; i++) out.push_back(states[i]->state);
+            return torch::stack(out);
+        };
 
-        auto deltas = compute_deltas(sequences.rewards, values, sequences.not_terminals, options.discount);
-        auto advantages = compute_advantages(deltas.detach(), sequences.not_terminals, options.discount, options.gae_discount);
-        auto value_loss = compute_value_loss(deltas);
-        auto policy_loss = compute_policy_loss(advantages, sequences.action_probabilities, action_probabilities, options.eps);
+        for (int64_t t = 0; t < length; t++)
+        {
+            auto state = stack_states();
+            std::vector<std::shared_ptr<policies::constraints::Base>> step_constraints{};
+            step_constraints.reserve(n);
+            for (int64_t i = 0; i < n; i++) {
+                constraints[i].push_back(states[i]->action_constraint);
+                step_constraints.push_back(states[i]->action_constraint);
+            }
+
+            auto model_output = model->forward(state);
+            model_output->policy->include(policies::constraints::stack(step_constraints));
+            auto actions = model_output->policy->sample();
+            auto action_probabilities = model_output->policy->prob(actions);
+
+            if (t == 0) {
+                re->states = torch::empty(cpputils::concat<int64_t>({n, length + 1}, state.sizes().slice(1).vec()), state.options());
+                re->actions = torch::empty(cpputils::concat<int64_t>({n, length}, actions.sizes().slice(1).vec()), actions.options());
+                re->action_probabilities = torch::empty({n, length}, action_probabilities.options());
+                re->state_values = torch::empty({n, length}, model_output->value.options());
+            }
+            re->states.select(1, t).copy_(state);
+            re->actions.select(1, t).copy_(actions);
+            re->action_probabilities.select(1, t).copy_(action_probabilities);
+            re->state_values.select(1, t).copy_(model_output->value);
+
+            if (options.logger) {
+                for (int64_t i = 0; i < n; i++) {
+                    if (!was_reset[i]) continue;
+                    if (options.log_start_value) options.logger->log_scalar("PPO/StartValue", model_output->value.index({i}).item().toFloat());
+                    if (options.log_start_entropy) options.logger->log_scalar("PPO/StartEntropy", model_output->policy->entropy().index({i}).item().toFloat());
+                }
+            }
+
+            for (int64_t i = 0; i < n; i++) {
+                pool.push_task([&, i] () {
+                    auto observation = envs[i]->step(actions.index({i}));
+                    rewards[i * length + t] = observation->reward;
+                    not_terminals[i * length + t] = !observation->terminal;
+                    was_reset[i] = observation->terminal;
+                    states[i] = observation->terminal ? std::shared_ptr<env::State>{envs[i]->reset()} : observation->state;
+                });
+            }
+            pool.wait_for_tasks();
+        }
+
+        re->states.select(1, length).copy_(stack_states());
+        re->rewards = torch::tensor(rewards, re->states.options()).view({n, length});
+        re->not_terminals = torch::tensor(not_terminals, torch::TensorOptions{}.dtype(torch::kBool).device(re->states.device())).view({n, length});
+
+        std::vector<std::shared_ptr<policies::constraints::Base>> sequence_constraints{};
+        sequence_constraints.reserve(n);
+        for (const auto &x : constraints) sequence_constraints.push_back(policies::constraints::stack(x));
+        re->constraints = policies::constraints::stack(sequence_constraints);
 
-        return value_loss + policy_loss;
+        return re;
     }
 
     Basic::Basic(
@@ -189,20 +254,15 @@ namespace rl::agents::ppo::trainers
         }
 
         while (std::chrono::steady_clock::now() < end) {
-            auto sequences = run_sequences(envs, model, options, pool);
-            CompiledSequences compiled{*sequences};
-
-            for (int i = 0; i < options.update_steps; i++) {
-                auto loss = loss_fn(compiled, model, options);
-                optimizer->zero_grad();
-                loss.backward();
-                optimizer->step();
-
-                if (options.logger && options.log_loss) {
-                    options.logger->log_scalar("PPO/Loss", loss.item().toFloat());
-                }
+            std::unique_ptr<CompiledSequences> compiled;
+            if (options.lockstep_rollouts) {
+                compiled = run_lockstep_sequences(envs, model, options, pool);
             }
-            if (options.logger) options.logger->log_frequency("PPO/UpdateFrequency", options.update_steps);
+            else {
+                compiled = run_sequences(envs, model, options, pool);
+            }
+
+            train_on_sequences(*compiled, model, optimizer, options);
         }
     }
 
@@ -0,0 +1,144 @@
+#include "rl/agents/ppo/trainers/batched.h"
+#include "rl/agents/ppo/trainers/batched_rollouts.h"
+
+#include "rl/cpputils/concat_vector.h"
+#include "rl/policies/constraints/constraints.h"
+#include "loss_fns.h"
+
+
+using namespace torch::indexing;
+using namespace rl;
+
+namespace rl::agents::ppo::trainers
+{
+
+    static
+    simulators::States reset_terminals(
+        const simulators::Observations &observations,
+        const std::shared_ptr<simulators::Base> &simulator
+    )
+    {
+        // All rows are reset and the terminal ones selected, which avoids
+        // synchronizing on whether any row is terminal.
+        const auto &next_states = observations.next_states;
+        const auto &terminals = observations.terminals;
+        auto n = terminals.size(0);
+        auto initial_states = simulator->reset(n);
+
+        auto terminal_shape = cpputils::concat<int64_t>({n}, std::vector<int64_t>(next_states.states.dim() - 1, 1));
+        auto states = torch::where(terminals.view(terminal_shape), initial_states.states, next_states.states);
+
+        auto stacked_constraints = policies::constraints::stack({next_states.action_constraints, initial_states.action_constraints});
+        std::shared_ptr<policies::constraints::Base> constraints = stacked_constraints->index(
+            {terminals.to(torch::kLong), torch::arange(n, terminals.options().dtype(torch::kLong))}
+        );
+
+        return {states, constraints};
+    }
+
+    std::unique_ptr<CompiledSequences> run_batched_sequences(
+        simulators::States *states,
+        std::shared_ptr<agents::ppo::Module> model,
+        std::shared_ptr<simulators::Base> simulator,
+        const BatchedOptions &options
+    )
+    {
+        torch::NoGradGuard no_grad{};
+        int64_t n = states->states.size(0);
+        int64_t length = options.sequence_length;
+
+        auto re = std::make_unique<CompiledSequences>();
+        std::vector<std::shared_ptr<policies::constraints::Base>> constraints{};
+        constraints.reserve(length);
+
+        // Values of reset states are accumulated over the rollout, and logged with
+        // one synchronization at its end. States reset in the last step are not
+        // evaluated within the rollout, and hence not logged.
+        bool log_start_value = options.logger && options.log_start_value;
+        torch::Tensor was_reset{};
+        torch::Tensor start_value_sum{}, start_value_count{};
+
+        for (int64_t t = 0; t < length; t++)
+        {
+            constraints.push_back(states->action_constraints);
+
+            auto model_output = model->forward(states->states);
+            model_output->policy->include(states->action_constraints);
+            auto actions = model_output->policy->sample();
+            auto action_probabilities = model_output->policy->prob(actions);
+
+            if (t == 0) {
+                re->states = torch::empty(cpputils::concat<int64_t>({n, length + 1}, states->states.sizes().slice(1).vec()), states->states.options());
+                re->actions = torch::empty(cpputils::concat<int64_t>({n, length}, actions.sizes().slice(1).vec()), actions.options());
+                re->action_probabilities = torch::empty({n, length}, action_probabilities.options());
+                re->state_values = torch::empty({n, length}, model_output->value.options());
+                start_value_sum = torch::zeros({}, model_output->value.options());
+                start_value_count = torch::zeros({}, model_output->value.options());
+            }
+            re->states.select(1, t).copy_(states->states);
+            re->actions.select(1, t).copy_(actions);
+            re->action_probabilities.select(1, t).copy_(action_probabilities);
+            re->state_values.select(1, t).copy_(model_output->value);
+
+            if (log_start_value && was_reset.defined()) {
+                auto reset_mask = was_reset.to(model_output->value.options());
+                start_value_sum += (model_output->value * reset_mask).sum();
+                start_value_count += reset_mask.sum();
+            }
+
+            auto observations = simulator->step(states->states, actions);
+            if (t == 0) {
+                re->rewards = torch::empty({n, length}, observations.rewards.options());
+                re->not_terminals = torch::empty({n, length}, observations.terminals.options().dtype(torch::kBool));
+            }
+            re->rewards.select(1, t).copy_(observations.rewards);
+            re->not_terminals.select(1, t).copy_(observations.terminals.logical_not());
+
+            was_reset = observations.terminals;
+            *states = reset_terminals(observations, simulator);
+        }
+
+        re->states.select(1, length).copy_(states->states);
+
+        // Stacking over time yields batch shape (L, N), transposed by indexing.
+        auto device = re->states.device();
+        auto time_indices = torch::arange(length, torch::TensorOptions{}.dtype(torch::kLong).device(device)).unsqueeze(0);
+        auto batch_indices = torch::arange(n, torch::TensorOptions{}.dtype(torch::kLong).device(device)).unsqueeze(1);
+        re->constraints = policies::constraints::stack(constraints)->index({time_indices, batch_indices});
+
+        if (log_start_value) {
+            auto start_value = torch::stack({start_value_sum, start_value_count}).to(torch::kFloat32).cpu();
+            auto accessor = start_value.accessor<float, 1>();
+            if (accessor[1] > 0) {
+                options.logger->log_scalar("PPO/StartValue", accessor[0] / accessor[1]);
+            }
+        }
+
+        return re;
+    }
+
+    Batched::Batched(
+        std::shared_ptr<agents::ppo::Module> model,
+        std::shared_ptr<torch::optim::Optimizer> optimizer,
+        std::shared_ptr<simulators::Base> simulator,
+        const BatchedOptions &options
+    ) : model{model}, optimizer{optimizer},
+        simulator{simulator}, options{options}
+    {}
+
+    template<class Rep, class Period>
+    void Batched::run(std::chrono::duration<Rep, Period> duration)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + duration;
+
+        auto states = simulator->reset(options.batchsize);
+
+        while (std::chrono::steady_clock::now() < end) {
+            auto sequences = run_batched_sequences(&states, model, simulator, options);
+            train_on_sequences(*sequences, model, optimizer, options);
+        }
+    }
+
+    template void Batched::run<int64_t, std::ratio<1L>>(std::chrono::duration<int64_t, std::ratio<1L>> duration);
+}
@@ -1,5 +1,7 @@
 #include "loss_fns.h"
 
+#include "rl/utils/reward/discounted_scan.h"
+
 
 using namespace torch::indexing;
 
@@ -21,19 +23,34 @@ namespace rl::agents::ppo::trainers
 
     torch::Tensor compute_advantages(torch::Tensor deltas, torch::Tensor not_terminals, float discount, float gae_discount)
     {
-        float d = discount * gae_discount;
-        auto A = torch::empty_like(deltas);
-
-        A.index_put_({"...", -1}, deltas.index({"...", -1}));
-        for (int k = A.size(1) - 2; k > -1; k--) {
-            A.index_put_({"...", k}, deltas.index({"...", k}) + d * not_terminals.index({"...", k}) * A.index({"...", k + 1}));
-        }
-
-        return A;
+        return rl::utils::reward::discounted_cumsum(deltas, not_terminals, discount * gae_discount);
     }
 
     torch::Tensor compute_value_loss(torch::Tensor deltas)
     {
         return deltas.square().mean();
     }
+
+    torch::Tensor compute_loss(
+        const CompiledSequences &sequences,
+        const std::shared_ptr<agents::ppo::Module> &model,
+        float discount,
+        float gae_discount,
+        float eps
+    )
+    {
+        auto model_output = model->forward(sequences.states.index({Slice(), Slice(None, -1)}));
+        model_output->policy->include(sequences.constraints);
+        auto action_probabilities = model_output->policy->prob(sequences.actions);
+
+        auto last_state_output = model->forward(sequences.states.index({Slice(), Slice(-1, None)}));
+        auto values = torch::cat({model_output->value, last_state_output->value}, 1);
+
+        auto deltas = compute_deltas(sequences.rewards, values, sequences.not_terminals, discount);
+        auto advantages = compute_advantages(deltas.detach(), sequences.not_terminals, discount, gae_discount);
+        auto value_loss = compute_value_loss(deltas);
+        auto policy_loss = compute_policy_loss(advantages, sequences.action_probabilities, action_probabilities, eps);
+
+        return value_loss + policy_loss;
+    }
 }
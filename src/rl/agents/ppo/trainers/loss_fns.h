@@ -2,8 +2,13 @@
 #define RL_AGENTS_PPO_TRAINERS_LOSS_FNS_H_
 
 
+#include <memory>
+
 #include <torch/torch.h>
 
+#include "rl/agents/ppo/module.h"
+#include "rl/agents/ppo/trainers/basic_rollouts.h"
+
 namespace rl::agents::ppo::trainers
 {
     torch::Tensor compute_policy_loss(torch::Tensor A, torch::Tensor old_probs, torch::Tensor new_probs, float eps);
@@ -13,6 +18,36 @@ namespace rl::agents::ppo::trainers
     torch::Tensor compute_advantages(torch::Tensor deltas, torch::Tensor not_terminals, float discount, float gae_discount);
 
     torch::Tensor compute_value_loss(torch::Tensor deltas);
+
+    torch::Tensor compute_loss(
+        const CompiledSequences &sequences,
+        const std::shared_ptr<agents::ppo::Module> &model,
+        float discount,
+        float gae_discount,
+        float eps
+    );
+
+    // Trains the model for `options.update_steps` steps on one batch of sequences.
+    template<class Options>
+    void train_on_sequences(
+        const CompiledSequences &sequences,
+        const std::shared_ptr<agents::ppo::Module> &model,
+        const std::shared_ptr<torch::optim::Optimizer> &optimizer,
+        const Options &options
+    )
+    {
+        for (int i = 0; i < options.update_steps; i++) {
+            auto loss = compute_loss(sequences, model, options.discount, options.gae_discount, options.eps);
+            optimizer->zero_grad();
+            loss.backward();
+            optimizer->step();
+
+            if (options.logger && options.log_loss) {
+                options.logger->log_scalar("PPO/Loss", loss.item().toFloat());
+            }
+        }
+        if (options.logger) options.logger->log_frequency("PPO/UpdateFrequency", options.update_steps);
+    }
 }
 
 #endif /* RL_AGENTS_PPO_TRAINERS_LOSS_FNS_H_ */
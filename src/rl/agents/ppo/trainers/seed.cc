@@ -8,6 +8,8 @@
 #include "rl/buffers/samplers/uniform.h"
 #include "rl/cpputils/concat_vector.h"
 #include "rl/cpputils/metronome.h"
+#include "rl/torchutils/gradient_norm.h"
+#include "rl/utils/reward/discounted_scan.h"
 
 #include "seed_impl/inference.h"
 #include "seed_impl/actor.h"
@@ -18,7 +20,7 @@
 
 using namespace rl;
 using namespace torch::indexing;
-using BufferType = buffers::TensorAndObject<std::shared_ptr<policies::constraints::Base>>;
+using BufferType = agents::ppo::trainers::seed_impl::SequenceBuffer;
 using SamplerType = buffers::samplers::Uniform<BufferType>;
 using DataStreamType = thread_safe::Queue<std::shared_ptr<agents::ppo::trainers::seed_impl::Sequence>>;
 
@@ -118,11 +120,6 @@ namespace rl::agents::ppo::trainers
                         .logger_(options.logger)
                         .device_(options.network_device)
                 );
-                inference_buffer = std::make_shared<BufferType>(
-                    options.inference_replay_size,
-                    tensor_info.shapes,
-                    tensor_options
-                );
                 training_buffer = std::make_shared<BufferType>(
                     options.replay_size,
                     tensor_info.shapes,
@@ -140,6 +137,7 @@ namespace rl::agents::ppo::trainers
                         std::make_shared<seed_impl::Actor>(
                             inference,
                             env_factory,
+                            training_buffer,
                             data_stream,
                             seed_impl::ActorOptions{}
                                 .environments_(options.envs_per_worker)
@@ -192,7 +190,6 @@ namespace rl::agents::ppo::trainers
 
             std::shared_ptr<seed_impl::Inference> inference;
             std::shared_ptr<DataStreamType> data_stream;
-            std::shared_ptr<BufferType> inference_buffer;
             std::shared_ptr<BufferType> training_buffer;
             std::shared_ptr<SamplerType> training_sampler;
             std::vector<std::shared_ptr<seed_impl::Actor>> actors;
@@ -233,29 +230,9 @@ namespace rl::agents::ppo::trainers
                     auto sequence = *stream_result;
                     std::shared_ptr<rl::policies::constraints::Base> constraints = policies::constraints::stack(sequence->constraints);
                     constraints->to(options.replay_device);
-                    inference_buffer->add(
-                        {
-                            torch::stack(sequence->states, 0).unsqueeze_(0).to(options.replay_device),
-                            torch::stack(sequence->actions, 0).unsqueeze_(0).to(options.replay_device),
-                            torch::tensor(sequence->rewards, torch::TensorOptions{}.dtype(sequence->states[0].dtype().toScalarType()).device(options.replay_device)).unsqueeze_(0).to(options.replay_device),
-                            torch::tensor(sequence->not_terminals, torch::TensorOptions{}.dtype(torch::kBool).device(options.replay_device)).unsqueeze_(0).to(options.replay_device),
-                            torch::stack(sequence->action_probabilities, 0).unsqueeze_(0).to(options.replay_device),
-                            torch::stack(sequence->state_values, 0).unsqueeze_(0).to(options.replay_device)
-                        },
-                        {constraints}
-                    );
-
-                    if (inference_buffer->size() == options.inference_replay_size)
-                    {
-                        auto data = inference_buffer->get_all();
-
-                        std::lock_guard lock{training_buffer_mtx};
-                        training_buffer->add(
-                            data->tensors, data->objs
-                        );
 
-                        inference_buffer->clear();
-                    }
+                    std::lock_guard lock{training_buffer_mtx};
+                    training_buffer->commit(sequence->row, constraints);
                 }
             }
 
@@ -293,9 +270,22 @@ namespace rl::agents::ppo::trainers
                     auto last_state_output = model->forward(sample->tensors[0].index({Slice(), Slice(-1, None)}));
                     auto values = torch::cat({model_output->value, last_state_output->value}, 1);
 
-                    auto deltas = compute_deltas(sample->tensors[2], values, sample->tensors[3], options.discount);
-                    auto advantages = compute_advantages(deltas.detach(), sample->tensors[3], options.discount, options.gae_discount);
-                    auto value_loss = compute_value_loss(deltas);
+                    torch::Tensor advantages, value_loss;
+                    if (options.vtrace) {
+                        auto vtrace = rl::utils::reward::vtrace(
+                            sample->tensors[2], values, sample->tensors[3], sample->tensors[4], action_probabilities,
+                            options.discount, options.gae_discount, options.vtrace_rho_max, options.vtrace_c_max
+                        );
+                        // The surrogate applies the importance ratio, hence the advantages
+                        // must not be rho weighted.
+                        advantages = vtrace.advantages;
+                        value_loss = compute_value_loss(vtrace.value_targets - values.index({Slice(), Slice(None, -1)}));
+                    }
+                    else {
+                        auto deltas = compute_deltas(sample->tensors[2], values, sample->tensors[3], options.discount);
+                        advantages = compute_advantages(deltas.detach(), sample->tensors[3], options.discount, options.gae_discount);
+                        value_loss = compute_value_loss(deltas);
+                    }
                     auto policy_loss = compute_policy_loss(advantages, sample->tensors[4], action_probabilities, options.eps);
                     torch::Tensor entropy_loss;
 
@@ -311,32 +301,13 @@ namespace rl::agents::ppo::trainers
 
                     assert(!loss.isnan().any().item().toBool());
 
-                    auto grad_norm = torch::tensor(0.0f, torch::TensorOptions{}.device(options.network_device));
+                    torch::Tensor grad_norm;
 
                     {
                         std::lock_guard network_lock{network_update_mtx};
                         optimizer->zero_grad();
                         loss.backward();
-
-                        for (const auto &param_group : optimizer->param_groups()) {
-                            for (const auto &param : param_group.params()) {
-                                grad_norm += param.grad().square().sum();
-                            }
-                        }
-                        grad_norm = grad_norm.sqrt();
-                        float grad_norm_f = grad_norm.item().toFloat();
-                        
-                        if (grad_norm_f > options.gradient_norm) {
-                            float factor = options.gradient_norm / grad_norm_f;
-
-                            for (const auto &param_group : optimizer->param_groups()) {
-                                for (const auto &param : param_group.params()) {
-                                    param.grad().mul_(factor);
-                                }
-                            }
-                            grad_norm.mul_(factor);
-                        }
-
+                        grad_norm = rl::torchutils::clip_gradient_norm(optimizer, options.gradient_norm);
                         optimizer->step();
                     }
 
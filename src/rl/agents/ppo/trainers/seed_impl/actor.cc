@@ -9,10 +9,11 @@ namespace rl::agents::ppo::trainers::seed_impl
     Actor::Actor(
         std::shared_ptr<Inference> inference,
         std::shared_ptr<rl::env::Factory> env_factory,
+        std::shared_ptr<SequenceBuffer> buffer,
         std::shared_ptr<thread_safe::Queue<std::shared_ptr<Sequence>>> out_stream,
         const ActorOptions &options
     ) :
-    inference{inference}, env_factory{env_factory}, out_stream{out_stream}, options{options}
+    inference{inference}, env_factory{env_factory}, buffer{buffer}, out_stream{out_stream}, options{options}
     {}
 
     void Actor::start()
@@ -54,7 +55,7 @@ namespace rl::agents::ppo::trainers::seed_impl
                 {
                     env_factory->get(),
                     nullptr,
-                    std::make_shared<Sequence>(options.sequence_length),
+                    std::make_shared<Sequence>(buffer->reserve(), options.sequence_length),
                     0
                 }
             );
@@ -100,21 +101,22 @@ namespace rl::agents::ppo::trainers::seed_impl
 
             int step = env.sequence_length++;
 
-            env.sequence->states.push_back(state->state);
+            auto &tensors = env.sequence->row.tensors;
+            tensors[kStates].select(0, step).copy_(state->state);
+            tensors[kActions].select(0, step).copy_(inference_result->action);
+            tensors[kRewards].select(0, step).fill_(transition->reward);
+            tensors[kNotTerminals].select(0, step).fill_(!transition->terminal);
+            tensors[kActionProbabilities].select(0, step).copy_(inference_result->action_probability);
+            tensors[kStateValues].select(0, step).copy_(inference_result->value);
             env.sequence->constraints.push_back(state->action_constraint);
-            env.sequence->state_values.push_back(inference_result->value);
-            env.sequence->rewards.push_back(transition->reward);
-            env.sequence->actions.push_back(inference_result->action);
-            env.sequence->action_probabilities.push_back(inference_result->action_probability);
-            env.sequence->not_terminals.push_back(!transition->terminal);
 
             if (env.sequence_length >= options.sequence_length) {
-                env.sequence->states.push_back(transition->state->state);
+                tensors[kStates].select(0, env.sequence_length).copy_(transition->state->state);
                 env.sequence->constraints.push_back(transition->state->action_constraint);
 
                 out_stream->enqueue(env.sequence);
                 env.sequence_length = 0;
-                env.sequence = std::make_shared<Sequence>(options.sequence_length);
+                env.sequence = std::make_shared<Sequence>(buffer->reserve(), options.sequence_length);
             }
 
             auto next_state = transition->state;
@@ -36,6 +36,7 @@ namespace rl::agents::ppo::trainers::seed_impl
             Actor(
                 std::shared_ptr<Inference> inference,
                 std::shared_ptr<rl::env::Factory> env_factory,
+                std::shared_ptr<SequenceBuffer> buffer,
                 std::shared_ptr<thread_safe::Queue<std::shared_ptr<Sequence>>> out_stream,
                 const ActorOptions &options={}
             );
@@ -48,6 +49,7 @@ namespace rl::agents::ppo::trainers::seed_impl
             const ActorOptions options;
             std::shared_ptr<Inference> inference;
             std::shared_ptr<rl::env::Factory> env_factory;
+            std::shared_ptr<SequenceBuffer> buffer;
             std::shared_ptr<thread_safe::Queue<std::shared_ptr<Sequence>>> out_stream;
 
             std::atomic<bool> is_running{false};
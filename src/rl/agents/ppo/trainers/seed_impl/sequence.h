@@ -2,33 +2,35 @@
 #define RL_AGENTS_PPO_TRAINERS_SEED_IMPL_SEQUENCE_H_
 
 #include <vector>
+#include <memory>
 
 
 #include <torch/torch.h>
 
+#include "rl/buffers/tensor_and_object.h"
 #include "rl/policies/constraints/base.h"
 
 namespace rl::agents::ppo::trainers::seed_impl
 {
+    using SequenceBuffer = rl::buffers::TensorAndObject<std::shared_ptr<policies::constraints::Base>>;
+
+    // Tensor indices of a sequence row.
+    enum SequenceTensor : int {
+        kStates = 0,
+        kActions = 1,
+        kRewards = 2,
+        kNotTerminals = 3,
+        kActionProbabilities = 4,
+        kStateValues = 5
+    };
+
     struct Sequence {
-        std::vector<torch::Tensor> states{};
-        std::vector<torch::Tensor> actions{};
-        std::vector<float> rewards{};
-        std::vector<uint8_t> not_terminals{};
-        std::vector<torch::Tensor> action_probabilities{};
-        std::vector<torch::Tensor> state_values{};
+        // Buffer row into which steps are written in place.
+        rl::buffers::TensorAndObjectRow row;
         std::vector<std::shared_ptr<policies::constraints::Base>> constraints{};
 
-        Sequence() {}
-
-        Sequence(int length)
+        Sequence(const rl::buffers::TensorAndObjectRow &row, int length) : row{row}
         {
-            states.reserve(length + 1);
-            actions.reserve(length);
-            rewards.reserve(length);
-            not_terminals.reserve(length);
-            action_probabilities.reserve(length);
-            state_values.reserve(length);   // Final state values not necessary
             constraints.reserve(length + 1);
         }
     };
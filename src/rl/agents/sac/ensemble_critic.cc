@@ -0,0 +1,67 @@
+#include "rl/agents/sac/ensemble_critic.h"
+
+#include <cmath>
+
+
+namespace rl::agents::sac
+{
+    MLPEnsembleCritic::MLPEnsembleCritic(int64_t input_size, const MLPEnsembleCriticOptions &options)
+    : input_size{input_size}, options{options}
+    {
+        auto sizes = options.hidden_sizes;
+        sizes.insert(sizes.begin(), input_size);
+        sizes.push_back(1);
+
+        for (int i = 0; i < sizes.size() - 1; i++) {
+            // Same initialization as torch::nn::Linear.
+            auto bound = 1.0 / std::sqrt(static_cast<double>(sizes[i]));
+            weights.push_back(
+                register_parameter(
+                    "weight" + std::to_string(i),
+                    torch::empty({options.ensemble_size, sizes[i], sizes[i + 1]}).uniform_(-bound, bound)
+                )
+            );
+            biases.push_back(
+                register_parameter(
+                    "bias" + std::to_string(i),
+                    torch::empty({options.ensemble_size, 1, sizes[i + 1]}).uniform_(-bound, bound)
+                )
+            );
+        }
+    }
+
+    CriticOutput MLPEnsembleCritic::forward(
+        const torch::Tensor &states,
+        const torch::Tensor &actions
+    )
+    {
+        auto batchsize = states.size(0);
+        auto x = torch::cat({states.flatten(1), actions.reshape({batchsize, -1}).to(states.dtype())}, 1);
+        x = x.unsqueeze(0).expand({options.ensemble_size, batchsize, input_size});
+
+        for (int i = 0; i < weights.size(); i++) {
+            x = torch::baddbmm(biases[i], x, weights[i]);
+            if (i < weights.size() - 1) x = x.relu();
+        }
+
+        return CriticOutput{x.squeeze(-1)};
+    }
+
+    int64_t MLPEnsembleCritic::size() const
+    {
+        return options.ensemble_size;
+    }
+
+    std::unique_ptr<EnsembleCritic> MLPEnsembleCritic::clone() const
+    {
+        auto out = std::make_unique<MLPEnsembleCritic>(input_size, options);
+        out->to(weights[0].device(), weights[0].scalar_type());
+
+        torch::NoGradGuard no_grad{};
+        for (int i = 0; i < weights.size(); i++) {
+            out->weights[i].copy_(weights[i]);
+            out->biases[i].copy_(biases[i]);
+        }
+        return out;
+    }
+}
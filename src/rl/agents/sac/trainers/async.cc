@@ -0,0 +1,209 @@
+#include "rl/agents/sac/trainers/async.h"
+
+#include <rl/policies/constraints/constraints.h>
+
+#include "helpers.h"
+
+
+namespace rl::agents::sac::trainers
+{
+
+    Async::Async(
+        std::shared_ptr<rl::agents::sac::Actor> actor,
+        std::vector<std::shared_ptr<rl::agents::sac::Critic>> critics,
+        std::shared_ptr<torch::optim::Optimizer> actor_optimizer,
+        std::vector<std::shared_ptr<torch::optim::Optimizer>> critic_optimizers,
+        std::shared_ptr<rl::env::Factory> env_factory,
+        const AsyncOptions &options
+    ) : 
+        options{options},
+        actor{actor},
+        actor_target{actor->clone()},
+        critics{critics},
+        actor_optimizer{actor_optimizer},
+        critic_optimizers{critic_optimizers},
+        env_factory{env_factory}
+    {}
+
+    Async::Async(
+        std::shared_ptr<rl::agents::sac::Actor> actor,
+        std::shared_ptr<rl::agents::sac::EnsembleCritic> critic,
+        std::shared_ptr<torch::optim::Optimizer> actor_optimizer,
+        std::shared_ptr<torch::optim::Optimizer> critic_optimizer,
+        std::shared_ptr<rl::env::Factory> env_factory,
+        const AsyncOptions &options
+    ) : 
+        options{options},
+        actor{actor},
+        actor_target{actor->clone()},
+        actor_optimizer{actor_optimizer},
+        critic_ensemble{critic},
+        critic_ensemble_optimizer{critic_optimizer},
+        env_factory{env_factory}
+    {}
+
+    void Async::initialize_buffer()
+    {
+        auto env = env_factory->get();
+        auto state = env->reset();
+
+        std::vector<std::vector<int64_t>> tensor_shapes{};
+        tensor_shapes.push_back(state->state.sizes().vec());   // States
+        tensor_shapes.push_back({});   // Actions
+        tensor_shapes.push_back({});   // Rewards
+        tensor_shapes.push_back({});   // Not terminals
+        tensor_shapes.push_back(state->state.sizes().vec());   // Next states
+
+        std::vector<torch::TensorOptions> tensor_options{};
+        tensor_options.push_back(state->state.options().device(options.replay_device));
+        tensor_options.push_back(torch::TensorOptions{}.device(options.replay_device));
+        tensor_options.push_back(torch::TensorOptions{}.device(options.replay_device));
+        tensor_options.push_back(torch::TensorOptions{}.dtype(torch::kBool).device(options.replay_device));
+        tensor_options.push_back(state->state.options().device(options.replay_device));
+
+        buffer = std::make_shared<rl::buffers::Tensor>(
+            options.replay_buffer_size,
+            tensor_shapes,
+            tensor_options
+        );
+        sampler = std::make_shared<rl::buffers::samplers::Uniform<rl::buffers::Tensor>>(buffer);
+    }
+
+    void Async::worker()
+    {
+        // Exceptions must not escape the thread. The first one stops training, and
+        // is rethrown by run().
+        try {
+            collect();
+        }
+        catch (...) {
+            std::lock_guard lock{worker_exception_mtx};
+            if (!worker_exception) worker_exception = std::current_exception();
+            running = false;
+        }
+    }
+
+    void Async::collect()
+    {
+        auto n = options.envs_per_worker;
+        std::vector<std::shared_ptr<rl::env::Base>> envs{};
+        std::vector<bool> is_start(n, true);
+        envs.reserve(n);
+        for (int i = 0; i < n; i++) {
+            envs.push_back(env_factory->get());
+            envs[i]->reset();
+        }
+
+        std::vector<torch::Tensor> states(n), next_states(n);
+        std::vector<std::shared_ptr<rl::policies::constraints::Base>> constraints(n);
+        std::vector<float> rewards(n);
+        std::vector<uint8_t> not_terminals(n);
+
+        while (running)
+        {
+            torch::InferenceMode guard{};
+
+            for (int i = 0; i < n; i++) {
+                auto state = envs[i]->state();
+                states[i] = state->state;
+                constraints[i] = state->action_constraint;
+            }
+            check_action_constraint(
+                rl::policies::constraints::stack(constraints), options.action_range_min, options.action_range_max
+            );
+
+            auto stacked_states = torch::stack(states);
+            auto output = actor->forward(stacked_states.to(options.network_device));
+            auto a = u_to_a(output.sample(), options.action_range_min, options.action_range_max);
+            auto env_actions = a.to(options.environment_device);
+
+            torch::Tensor values;
+            if (options.logger) values = output.value().cpu();
+
+            for (int i = 0; i < n; i++) {
+                auto observation = envs[i]->step(env_actions.index({i}));
+                next_states[i] = observation->state->state;
+                rewards[i] = observation->reward;
+                not_terminals[i] = !observation->terminal;
+
+                if (options.logger) {
+                    if (is_start[i]) options.logger->log_scalar("SAC/StartValue", values.index({i}).item().toFloat());
+                    if (observation->terminal) options.logger->log_scalar("SAC/EndValue", values.index({i}).item().toFloat());
+                }
+                is_start[i] = observation->terminal;
+                if (observation->terminal) envs[i]->reset();
+            }
+
+            buffer->add(
+                {
+                    stacked_states.to(options.replay_device),
+                    a.to(options.replay_device),
+                    torch::tensor(rewards, buffer->tensor_options()[2]),
+                    torch::tensor(not_terminals, buffer->tensor_options()[3]),
+                    torch::stack(next_states).to(options.replay_device)
+                }
+            );
+            env_steps += n;
+        }
+    }
+
+    void Async::run(size_t duration)
+    {
+        initialize_buffer();
+
+        auto stop_time = std::chrono::high_resolution_clock::now() + std::chrono::seconds{duration};
+        worker_exception = nullptr;
+        running = true;
+        for (int i = 0; i < options.env_workers; i++) {
+            worker_threads.push_back(std::thread(&Async::worker, this));
+        }
+
+        while (running && std::chrono::high_resolution_clock::now() < stop_time && buffer->size() < options.minimum_replay_buffer_size) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        size_t initial_env_steps = env_steps;
+        auto training_step_options = TrainingStepOptions{}
+            .temperature_(options.temperature)
+            .action_range_min_(options.action_range_min)
+            .action_range_max_(options.action_range_max)
+            .huber_loss_delta_(options.huber_loss_delta)
+            .max_gradient_norm_(options.max_gradient_norm)
+            .network_device_(options.network_device)
+            .target_network_lr_(options.target_network_lr)
+            .discount_(options.discount)
+            .logger_(options.logger);
+
+        while (running && std::chrono::high_resolution_clock::now() < stop_time)
+        {
+            if (train_steps >= options.update_to_data_ratio * (env_steps - initial_env_steps)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            auto sample = sampler->sample(options.batch_size);
+            if (critic_ensemble) {
+                training_step(
+                    *sample, actor, actor_target, critic_ensemble, actor_optimizer, critic_ensemble_optimizer, training_step_options
+                );
+            }
+            else {
+                training_step(
+                    *sample, actor, actor_target, critics, actor_optimizer, critic_optimizers, training_step_options
+                );
+            }
+            train_steps++;
+
+            if (options.logger) options.logger->log_frequency("SAC/UpdateFrequency", 1);
+            if (train_steps % options.checkpoint_callback_period == 0) {
+                if (options.checkpoint_callback) options.checkpoint_callback(train_steps);
+            }
+        }
+
+        running = false;
+        for (auto &thread : worker_threads) thread.join();
+        worker_threads.clear();
+
+        if (worker_exception) std::rethrow_exception(worker_exception);
+    }
+}
@@ -1,9 +1,8 @@
 #include "rl/agents/sac/trainers/basic.h"
 
-#include <rl/torchutils/torchutils.h>
+#include "helpers.h"
 
 
-namespace F = torch::nn::functional;
 namespace rl::agents::sac::trainers
 {
 
@@ -24,6 +23,23 @@ namespace rl::agents::sac::trainers
         env_factory{env_factory}
     {}
 
+    Basic::Basic(
+        std::shared_ptr<rl::agents::sac::Actor> actor,
+        std::shared_ptr<rl::agents::sac::EnsembleCritic> critic,
+        std::shared_ptr<torch::optim::Optimizer> actor_optimizer,
+        std::shared_ptr<torch::optim::Optimizer> critic_optimizer,
+        std::shared_ptr<rl::env::Factory> env_factory,
+        const BasicOptions &options
+    ) : 
+        options{options},
+        actor{actor},
+        actor_target{actor->clone()},
+        actor_optimizer{actor_optimizer},
+        critic_ensemble{critic},
+        critic_ensemble_optimizer{critic_optimizer},
+        env_factory{env_factory}
+    {}
+
     void Basic::initialize_buffer()
     {
         auto env = env_factory->get();
@@ -52,36 +68,6 @@ namespace rl::agents::sac::trainers
         sampler = std::make_shared<rl::buffers::samplers::Uniform<rl::buffers::Tensor>>(buffer);
     }
 
-    torch::Tensor Basic::u_to_a(const torch::Tensor &u) {
-        auto a = u.tanh();
-        return 0.5f * (a + 1.0f) * (options.action_range_max - options.action_range_min) + options.action_range_min;
-    }
-
-    torch::Tensor Basic::a_to_u(const torch::Tensor &a) {
-        return torch::arctanh(2.0f * (a - options.action_range_min) / (options.action_range_max - options.action_range_min) - 1.0f);
-    }
-
-    torch::Tensor Basic::log_pi_a(const torch::Tensor &u_, const ActorOutput &actor_output)
-    {
-        auto mean = actor_output.mean();
-        auto std = actor_output.std();
-        auto u = u_;
-
-        assert(mean.sizes().size() > 0);
-        if (mean.sizes().size() == 1) {
-            mean = mean.unsqueeze(1);
-            std = std.unsqueeze(1);
-            u = u.unsqueeze(1);
-        }
-        assert(mean.sizes().size() == 2);
-        assert(std.sizes().size() == 2);
-        assert(u.sizes().size() == 2);
-
-        auto log_mu = -0.5f * ((u - mean) / std).square_().sum(-1) - (2.5066282746310002f * std).log().sum(-1);
-        auto out = log_mu - (1.0f - u.tanh().square()).log().sum(-1);
-        return out;
-    }
-
     void Basic::init_env() {
         env = env_factory->get();
     }
@@ -99,19 +85,7 @@ namespace rl::agents::sac::trainers
         }
 
         std::shared_ptr<rl::env::State> state = env->state();
-        if (state->action_constraint->is_type<rl::policies::constraints::Empty>()) {}
-        else if (state->action_constraint->is_type<rl::policies::constraints::Box>()) {
-            auto &box = state->action_constraint->as_type<rl::policies::constraints::Box>();
-            if (
-                !box.upper_bound().le(options.action_range_max).all().item().toBool()
-                || !box.lower_bound().ge(options.action_range_min).all().item().toBool()
-            ) {
-                throw std::runtime_error{"Action constraint not fulfilled."};
-            }
-        }
-        else {
-            throw std::runtime_error{"Unsupported action constraint, WIP..."};
-        }
+        check_action_constraint(state->action_constraint, options.action_range_min, options.action_range_max);
 
         auto output = actor->forward( state->state.unsqueeze(0).to(options.network_device) );
         
@@ -120,7 +94,7 @@ namespace rl::agents::sac::trainers
         }
 
         auto u = output.sample().squeeze(0);
-        auto a = u_to_a(u);
+        auto a = u_to_a(u, options.action_range_min, options.action_range_max);
         
         auto observation = env->step(a.to(options.environment_device));
         
@@ -146,130 +120,29 @@ namespace rl::agents::sac::trainers
 
     void Basic::execute_train_step()
     {
-        auto sample_storage = sampler->sample(options.batch_size);
-        auto &sample = *sample_storage;
-
-        torch::Tensor value_loss, policy_loss;
-        std::vector<torch::Tensor> critic_losses{}; critic_losses.reserve(critics.size());
-        auto current_policy = actor->forward(sample[0].to(options.network_device));
-
-        // Compute value loss
-        {
-            torch::Tensor critic_outputs, entropy_estimator;
-            {
-                torch::NoGradGuard guard{};
-                auto u = current_policy.sample().detach();
-                auto a = u_to_a(u);
-                entropy_estimator = - log_pi_a(u, current_policy);
-
-                critic_outputs = critics[0]->forward(sample[0].to(options.network_device), a).value();
-                for (int i = 0; i < critics.size(); i++) {
-                    critic_outputs = critic_outputs.min(critics[i]->forward(sample[0].to(options.network_device), a).value());
-                }
-            }
-            value_loss = F::huber_loss(
-                current_policy.value(),
-                critic_outputs + options.temperature * entropy_estimator,
-                F::HuberLossFuncOptions{}.reduction(torch::kNone).delta(options.huber_loss_delta)
+        auto sample = sampler->sample(options.batch_size);
+        auto training_step_options = TrainingStepOptions{}
+            .temperature_(options.temperature)
+            .action_range_min_(options.action_range_min)
+            .action_range_max_(options.action_range_max)
+            .huber_loss_delta_(options.huber_loss_delta)
+            .max_gradient_norm_(options.max_gradient_norm)
+            .network_device_(options.network_device)
+            .target_network_lr_(options.target_network_lr)
+            .discount_(options.discount)
+            .logger_(options.logger);
+
+        if (critic_ensemble) {
+            training_step(
+                *sample, actor, actor_target, critic_ensemble, actor_optimizer, critic_ensemble_optimizer, training_step_options
             );
-            assert (!value_loss.isnan().any().item().toBool());
-        }
-
-        // Compute critic losses
-        {
-            torch::Tensor target;
-            {
-                torch::NoGradGuard guard{};
-                auto next_policy = actor_target->forward(sample[4].to(options.network_device));
-                target = sample[2].to(options.network_device) + options.discount * sample[3].to(options.network_device) * next_policy.value();
-            }
-
-            for (int i = 0; i < critics.size(); i++) {
-                auto value = critics[i]->forward(sample[0].to(options.network_device), sample[1].to(options.network_device)).value();
-                critic_losses.push_back(
-                    F::huber_loss(
-                        value,
-                        target,
-                        F::HuberLossFuncOptions{}.reduction(torch::kNone).delta(options.huber_loss_delta)
-                    )
-                );
-
-                assert(!critic_losses[i].isnan().any().item().toBool());
-            }
-        }
-
-        // Compute policy loss
-        {
-            auto u = current_policy.sample();
-            auto a = u_to_a(u);
-            torch::Tensor critic_outputs = critics[0]->forward(sample[0].to(options.network_device), a).value();
-            for (int i = 0; i < critics.size(); i++) {
-                critic_outputs = critic_outputs.min(critics[i]->forward(sample[0].to(options.network_device), a).value());
-            }
-            policy_loss = log_pi_a(u, current_policy) - critic_outputs;
-            assert(!policy_loss.isnan().any().item().toBool());
-        }
-
-        auto mean_policy_loss = policy_loss.mean();
-        auto mean_value_loss = value_loss.mean();
-        auto actor_loss = mean_policy_loss + mean_value_loss;
-        std::vector<torch::Tensor> mean_critic_losses{};
-        mean_critic_losses.reserve(critics.size());
-        for (int i = 0; i < critics.size(); i++) {
-            mean_critic_losses.push_back(critic_losses[i].mean());
         }
-
-        // Apply backward passes
-        actor_optimizer->zero_grad();
-        actor_loss.backward();
-        auto actor_grad_norm = rl::torchutils::compute_gradient_norm(actor_optimizer);
-        auto grad_norm_factor = torch::where(
-            actor_grad_norm > options.max_gradient_norm,
-            options.max_gradient_norm / actor_grad_norm,
-            torch::ones_like(actor_grad_norm)
-        );
-        rl::torchutils::scale_gradients(actor_optimizer, grad_norm_factor);
-        actor_optimizer->step();
-
-        std::vector<torch::Tensor> critic_grad_norms{}; critic_grad_norms.resize(critics.size());
-        for (int i = 0; i < critics.size(); i++)
-        {
-            critic_optimizers[i]->zero_grad();
-            mean_critic_losses[i].backward();
-            critic_grad_norms[i] = rl::torchutils::compute_gradient_norm(critic_optimizers[i]);
-            auto grad_norm_factor = torch::where(
-                critic_grad_norms[i] > options.max_gradient_norm,
-                options.max_gradient_norm / critic_grad_norms[i],
-                torch::ones_like(critic_grad_norms[i])
+        else {
+            training_step(
+                *sample, actor, actor_target, critics, actor_optimizer, critic_optimizers, training_step_options
             );
-            rl::torchutils::scale_gradients(critic_optimizers[i], grad_norm_factor);
-            critic_optimizers[i]->step();
-        }
-
-        if (options.logger) {
-            options.logger->log_scalar("SAC/PolicyLoss", mean_policy_loss.item().toFloat());
-            options.logger->log_scalar("SAC/ValueLoss", mean_value_loss.item().toFloat());
-            for (int i = 0; i < critics.size(); i++) {
-                options.logger->log_scalar("SAC/CriticLoss" + std::to_string(i), mean_critic_losses[i].item().toFloat());
-            }
-
-            options.logger->log_scalar("SAC/ActorGradNorm", actor_grad_norm.item().toFloat());
-            for (int i = 0; i < critics.size(); i++) {
-                options.logger->log_scalar("SAC/CriticGradNorm" + std::to_string(i), critic_grad_norms[i].item().toFloat());
-            }
-        }
-
-        {
-            torch::NoGradGuard guard{};
-            auto target_parameters = actor_target->parameters();
-            auto parameters = actor->parameters();
-
-            for (int i = 0; i < parameters.size(); i++) {
-                target_parameters[i].add_(options.target_network_lr * (parameters[i] - target_parameters[i]));
-            }
-
-            train_steps++;
         }
+        train_steps++;
     }
 
     void Basic::run(size_t duration)
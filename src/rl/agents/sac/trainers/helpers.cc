@@ -0,0 +1,224 @@
+#include "helpers.h"
+
+#include <functional>
+
+#include <rl/policies/constraints/constraints.h>
+#include <rl/torchutils/torchutils.h>
+
+
+namespace F = torch::nn::functional;
+namespace rl::agents::sac::trainers
+{
+    torch::Tensor u_to_a(const torch::Tensor &u, float action_range_min, float action_range_max) {
+        auto a = u.tanh();
+        return 0.5f * (a + 1.0f) * (action_range_max - action_range_min) + action_range_min;
+    }
+
+    torch::Tensor a_to_u(const torch::Tensor &a, float action_range_min, float action_range_max) {
+        return torch::arctanh(2.0f * (a - action_range_min) / (action_range_max - action_range_min) - 1.0f);
+    }
+
+    torch::Tensor log_pi_a(const torch::Tensor &u_, const ActorOutput &actor_output)
+    {
+        auto mean = actor_output.mean();
+        auto std = actor_output.std();
+        auto u = u_;
+
+        assert(mean.sizes().size() > 0);
+        if (mean.sizes().size() == 1) {
+            mean = mean.unsqueeze(1);
+            std = std.unsqueeze(1);
+            u = u.unsqueeze(1);
+        }
+        assert(mean.sizes().size() == 2);
+        assert(std.sizes().size() == 2);
+        assert(u.sizes().size() == 2);
+
+        auto log_mu = -0.5f * ((u - mean) / std).square_().sum(-1) - (2.5066282746310002f * std).log().sum(-1);
+        auto out = log_mu - (1.0f - u.tanh().square()).log().sum(-1);
+        return out;
+    }
+
+    void check_action_constraint(
+        const std::shared_ptr<rl::policies::constraints::Base> &constraint,
+        float action_range_min,
+        float action_range_max
+    )
+    {
+        if (constraint->is_type<rl::policies::constraints::Empty>()) {}
+        else if (constraint->is_type<rl::policies::constraints::Box>()) {
+            auto &box = constraint->as_type<rl::policies::constraints::Box>();
+            if (
+                !box.upper_bound().le(action_range_max).all().item().toBool()
+                || !box.lower_bound().ge(action_range_min).all().item().toBool()
+            ) {
+                throw std::runtime_error{"Action constraint not fulfilled."};
+            }
+        }
+        else {
+            throw std::runtime_error{"Unsupported action constraint, WIP..."};
+        }
+    }
+
+    namespace
+    {
+        // Evaluates all critics, returning values of shape (E, B).
+        using CriticValues = std::function<torch::Tensor(const torch::Tensor &, const torch::Tensor &)>;
+        // Clips the gradients of all critics, returning the norm of each, shape (E).
+        using CriticGradientClip = std::function<torch::Tensor()>;
+
+        void training_step_impl(
+            const std::vector<torch::Tensor> &sample,
+            const std::shared_ptr<rl::agents::sac::Actor> &actor,
+            const std::shared_ptr<rl::agents::sac::Actor> &actor_target,
+            const CriticValues &critic_values,
+            const std::shared_ptr<torch::optim::Optimizer> &actor_optimizer,
+            const std::vector<std::shared_ptr<torch::optim::Optimizer>> &critic_optimizers,
+            const CriticGradientClip &clip_critic_gradients,
+            const TrainingStepOptions &options
+        )
+        {
+            auto states = sample[0].to(options.network_device);
+            torch::Tensor value_loss, policy_loss, critic_losses;
+            auto current_policy = actor->forward(states);
+
+            // Compute value loss
+            {
+                torch::Tensor critic_outputs, entropy_estimator;
+                {
+                    torch::NoGradGuard guard{};
+                    auto u = current_policy.sample().detach();
+                    auto a = u_to_a(u, options.action_range_min, options.action_range_max);
+                    entropy_estimator = - log_pi_a(u, current_policy);
+                    critic_outputs = std::get<0>(critic_values(states, a).min(0));
+                }
+                value_loss = F::huber_loss(
+                    current_policy.value(),
+                    critic_outputs + options.temperature * entropy_estimator,
+                    F::HuberLossFuncOptions{}.reduction(torch::kNone).delta(options.huber_loss_delta)
+                );
+                assert (!value_loss.isnan().any().item().toBool());
+            }
+
+            // Compute critic losses
+            {
+                torch::Tensor target;
+                {
+                    torch::NoGradGuard guard{};
+                    auto next_policy = actor_target->forward(sample[4].to(options.network_device));
+                    target = sample[2].to(options.network_device) + options.discount * sample[3].to(options.network_device) * next_policy.value();
+                }
+
+                auto values = critic_values(states, sample[1].to(options.network_device));
+                critic_losses = F::huber_loss(
+                    values,
+                    target.unsqueeze(0).expand_as(values),
+                    F::HuberLossFuncOptions{}.reduction(torch::kNone).delta(options.huber_loss_delta)
+                );
+                assert(!critic_losses.isnan().any().item().toBool());
+            }
+
+            // Compute policy loss
+            {
+                auto u = current_policy.sample();
+                auto a = u_to_a(u, options.action_range_min, options.action_range_max);
+                auto critic_outputs = std::get<0>(critic_values(states, a).min(0));
+                policy_loss = log_pi_a(u, current_policy) - critic_outputs;
+                assert(!policy_loss.isnan().any().item().toBool());
+            }
+
+            auto mean_policy_loss = policy_loss.mean();
+            auto mean_value_loss = value_loss.mean();
+            auto actor_loss = mean_policy_loss + mean_value_loss;
+            auto mean_critic_losses = critic_losses.mean(1);
+
+            // Apply backward passes
+            actor_optimizer->zero_grad();
+            actor_loss.backward();
+            auto actor_grad_norm = rl::torchutils::clip_gradient_norm(actor_optimizer, options.max_gradient_norm);
+            actor_optimizer->step();
+
+            // Critics have disjoint parameters, hence one backward pass of the summed
+            // losses yields the gradients of each critic loss.
+            for (auto &optimizer : critic_optimizers) optimizer->zero_grad();
+            mean_critic_losses.sum().backward();
+            auto critic_grad_norms = clip_critic_gradients();
+            for (auto &optimizer : critic_optimizers) optimizer->step();
+
+            if (options.logger) {
+                options.logger->log_scalar("SAC/PolicyLoss", mean_policy_loss.item().toFloat());
+                options.logger->log_scalar("SAC/ValueLoss", mean_value_loss.item().toFloat());
+                auto critic_losses_cpu = mean_critic_losses.detach().cpu();
+                for (int i = 0; i < critic_losses_cpu.size(0); i++) {
+                    options.logger->log_scalar("SAC/CriticLoss" + std::to_string(i), critic_losses_cpu[i].item().toFloat());
+                }
+
+                options.logger->log_scalar("SAC/ActorGradNorm", actor_grad_norm.item().toFloat());
+                auto critic_grad_norms_cpu = critic_grad_norms.cpu();
+                for (int i = 0; i < critic_grad_norms_cpu.size(0); i++) {
+                    options.logger->log_scalar("SAC/CriticGradNorm" + std::to_string(i), critic_grad_norms_cpu[i].item().toFloat());
+                }
+            }
+
+            rl::torchutils::polyak_update(
+                actor_target->parameters(), actor->parameters(), options.target_network_lr
+            );
+        }
+    }
+
+    void training_step(
+        const std::vector<torch::Tensor> &sample,
+        const std::shared_ptr<rl::agents::sac::Actor> &actor,
+        const std::shared_ptr<rl::agents::sac::Actor> &actor_target,
+        const std::vector<std::shared_ptr<rl::agents::sac::Critic>> &critics,
+        const std::shared_ptr<torch::optim::Optimizer> &actor_optimizer,
+        const std::vector<std::shared_ptr<torch::optim::Optimizer>> &critic_optimizers,
+        const TrainingStepOptions &options
+    )
+    {
+        auto critic_values = [&critics] (const torch::Tensor &states, const torch::Tensor &actions) {
+            std::vector<torch::Tensor> values{};
+            values.reserve(critics.size());
+            for (const auto &critic : critics) {
+                values.push_back(critic->forward(states, actions).value());
+            }
+            return torch::stack(values);
+        };
+        auto clip_critic_gradients = [&critic_optimizers, &options] () {
+            std::vector<torch::Tensor> norms{};
+            norms.reserve(critic_optimizers.size());
+            for (const auto &optimizer : critic_optimizers) {
+                norms.push_back(rl::torchutils::clip_gradient_norm(optimizer, options.max_gradient_norm));
+            }
+            return torch::stack(norms);
+        };
+        training_step_impl(
+            sample, actor, actor_target, critic_values, actor_optimizer,
+            critic_optimizers, clip_critic_gradients, options
+        );
+    }
+
+    void training_step(
+        const std::vector<torch::Tensor> &sample,
+        const std::shared_ptr<rl::agents::sac::Actor> &actor,
+        const std::shared_ptr<rl::agents::sac::Actor> &actor_target,
+        const std::shared_ptr<rl::agents::sac::EnsembleCritic> &critic,
+        const std::shared_ptr<torch::optim::Optimizer> &actor_optimizer,
+        const std::shared_ptr<torch::optim::Optimizer> &critic_optimizer,
+        const TrainingStepOptions &options
+    )
+    {
+        auto critic_values = [&critic] (const torch::Tensor &states, const torch::Tensor &actions) {
+            return critic->forward(states, actions).value();
+        };
+        // One norm over the whole ensemble would grow with its size, hence each
+        // member is clipped on its own slice of the stacked parameters.
+        auto clip_critic_gradients = [&critic_optimizer, &options] () {
+            return rl::torchutils::clip_ensemble_gradient_norm(critic_optimizer, options.max_gradient_norm);
+        };
+        training_step_impl(
+            sample, actor, actor_target, critic_values, actor_optimizer,
+            {critic_optimizer}, clip_critic_gradients, options
+        );
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef RL_AGENTS_SAC_TRAINERS_HELPERS_H_
+#define RL_AGENTS_SAC_TRAINERS_HELPERS_H_
+
+
+#include <memory>
+#include <vector>
+
+#include <torch/torch.h>
+
+#include <rl/option.h>
+#include <rl/agents/sac/actor.h>
+#include <rl/agents/sac/critic.h>
+#include <rl/agents/sac/ensemble_critic.h>
+#include <rl/logging/client/base.h>
+#include <rl/policies/constraints/base.h>
+
+namespace rl::agents::sac::trainers
+{
+    // Options shared by all SAC trainers for executing one training step.
+    struct TrainingStepOptions
+    {
+        RL_OPTION(float, temperature) = 0.01f;
+        RL_OPTION(float, action_range_min) = -1.0f;
+        RL_OPTION(float, action_range_max) = 1.0f;
+        RL_OPTION(float, huber_loss_delta) = 2.0f;
+        RL_OPTION(float, max_gradient_norm) = 40.0f;
+        RL_OPTION(torch::Device, network_device) = torch::kCPU;
+        RL_OPTION(float, target_network_lr) = 1e-3;
+        RL_OPTION(float, discount) = 0.99;
+        RL_OPTION(std::shared_ptr<rl::logging::client::Base>, logger) = nullptr;
+    };
+
+    torch::Tensor u_to_a(const torch::Tensor &u, float action_range_min, float action_range_max);
+
+    torch::Tensor a_to_u(const torch::Tensor &a, float action_range_min, float action_range_max);
+
+    torch::Tensor log_pi_a(const torch::Tensor &u, const ActorOutput &actor_output);
+
+    // Throws unless the constraint is empty, or a box within the action range.
+    void check_action_constraint(
+        const std::shared_ptr<rl::policies::constraints::Base> &constraint,
+        float action_range_min,
+        float action_range_max
+    );
+
+    // Executes one training step on a sample of (states, actions, rewards,
+    // not_terminals, next_states).
+    void training_step(
+        const std::vector<torch::Tensor> &sample,
+        const std::shared_ptr<rl::agents::sac::Actor> &actor,
+        const std::shared_ptr<rl::agents::sac::Actor> &actor_target,
+        const std::vector<std::shared_ptr<rl::agents::sac::Critic>> &critics,
+        const std::shared_ptr<torch::optim::Optimizer> &actor_optimizer,
+        const std::vector<std::shared_ptr<torch::optim::Optimizer>> &critic_optimizers,
+        const TrainingStepOptions &options
+    );
+
+    // Executes one training step, evaluating all critics of the ensemble in one
+    // forward pass and updating them in one optimizer step. Gradients are clipped
+    // per member.
+    void training_step(
+        const std::vector<torch::Tensor> &sample,
+        const std::shared_ptr<rl::agents::sac::Actor> &actor,
+        const std::shared_ptr<rl::agents::sac::Actor> &actor_target,
+        const std::shared_ptr<rl::agents::sac::EnsembleCritic> &critic,
+        const std::shared_ptr<torch::optim::Optimizer> &actor_optimizer,
+        const std::shared_ptr<torch::optim::Optimizer> &critic_optimizer,
+        const TrainingStepOptions &options
+    );
+}
+
+#endif /* RL_AGENTS_SAC_TRAINERS_HELPERS_H_ */
@@ -0,0 +1,234 @@
+#include "rl/agents/utils/categorical_projection.h"
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <torch/library.h>
+
+
+namespace rl::agents::utils
+{
+    namespace
+    {
+        // Lower and upper support indices of a projected atom, and its position
+        // b on the support. Indices always differ, such that the mass of an
+        // atom projected exactly onto the support ends up in one index.
+        template<typename scalar_t>
+        inline
+        void support_indices(
+            scalar_t projection,
+            scalar_t v_min,
+            scalar_t v_max,
+            scalar_t dz,
+            int64_t n_atoms,
+            int64_t *lower,
+            int64_t *upper,
+            scalar_t *b
+        )
+        {
+            projection = std::min(std::max(projection, v_min), v_max);
+            *b = (projection - v_min) / dz;
+            *lower = std::min(std::max(static_cast<int64_t>(std::floor(*b)), int64_t{0}), n_atoms - 1);
+            *upper = std::min(std::max(static_cast<int64_t>(std::ceil(*b)), int64_t{0}), n_atoms - 1);
+
+            if (*lower == *upper) {
+                if (*upper > 0) {
+                    *lower -= 1;
+                }
+                else if (*lower < n_atoms - 1) {
+                    *upper += 1;
+                }
+            }
+        }
+
+        struct ProjectionInputs
+        {
+            torch::Tensor rewards;
+            torch::Tensor not_terminals;
+            torch::Tensor atoms;
+        };
+
+        ProjectionInputs prepare_inputs(
+            const torch::Tensor &rewards,
+            const torch::Tensor &not_terminals,
+            const torch::Tensor &atoms,
+            torch::ScalarType dtype
+        )
+        {
+            return ProjectionInputs{
+                rewards.to(dtype).contiguous(),
+                not_terminals.to(dtype).contiguous(),
+                atoms.to(dtype).contiguous()
+            };
+        }
+
+        torch::Tensor categorical_projection_cpu(
+            const torch::Tensor &next_distribution,
+            const torch::Tensor &rewards,
+            const torch::Tensor &not_terminals,
+            const torch::Tensor &atoms,
+            double discount
+        )
+        {
+            auto distribution = next_distribution.contiguous();
+            auto inputs = prepare_inputs(rewards, not_terminals, atoms, distribution.scalar_type());
+            auto m = torch::zeros_like(distribution);
+            auto batchsize = distribution.size(0);
+            auto n_atoms = distribution.size(1);
+
+            AT_DISPATCH_FLOATING_TYPES(distribution.scalar_type(), "categorical_projection_cpu", [&] {
+                auto p = distribution.data_ptr<scalar_t>();
+                auto r = inputs.rewards.data_ptr<scalar_t>();
+                auto nt = inputs.not_terminals.data_ptr<scalar_t>();
+                auto z = inputs.atoms.data_ptr<scalar_t>();
+                auto out = m.data_ptr<scalar_t>();
+                auto v_min = z[0], v_max = z[n_atoms - 1], dz = z[1] - z[0];
+                auto gamma = static_cast<scalar_t>(discount);
+
+                at::parallel_for(0, batchsize, 16, [&] (int64_t begin, int64_t end) {
+                    for (int64_t i = begin; i < end; i++) {
+                        auto row = p + i * n_atoms;
+                        auto m_row = out + i * n_atoms;
+                        for (int64_t j = 0; j < n_atoms; j++) {
+                            int64_t lower, upper;
+                            scalar_t b;
+                            support_indices(r[i] + nt[i] * gamma * z[j], v_min, v_max, dz, n_atoms, &lower, &upper, &b);
+                            m_row[lower] += row[j] * (upper - b);
+                            m_row[upper] += row[j] * (b - lower);
+                        }
+                    }
+                });
+            });
+
+            return m;
+        }
+
+        torch::Tensor categorical_projection_backward_cpu(
+            const torch::Tensor &grad_output,
+            const torch::Tensor &rewards,
+            const torch::Tensor &not_terminals,
+            const torch::Tensor &atoms,
+            double discount
+        )
+        {
+            auto grad_m = grad_output.contiguous();
+            auto inputs = prepare_inputs(rewards, not_terminals, atoms, grad_m.scalar_type());
+            auto grad = torch::empty_like(grad_m);
+            auto batchsize = grad_m.size(0);
+            auto n_atoms = grad_m.size(1);
+
+            AT_DISPATCH_FLOATING_TYPES(grad_m.scalar_type(), "categorical_projection_backward_cpu", [&] {
+                auto g = grad_m.data_ptr<scalar_t>();
+                auto r = inputs.rewards.data_ptr<scalar_t>();
+                auto nt = inputs.not_terminals.data_ptr<scalar_t>();
+                auto z = inputs.atoms.data_ptr<scalar_t>();
+                auto out = grad.data_ptr<scalar_t>();
+                auto v_min = z[0], v_max = z[n_atoms - 1], dz = z[1] - z[0];
+                auto gamma = static_cast<scalar_t>(discount);
+
+                at::parallel_for(0, batchsize, 16, [&] (int64_t begin, int64_t end) {
+                    for (int64_t i = begin; i < end; i++) {
+                        auto g_row = g + i * n_atoms;
+                        auto out_row = out + i * n_atoms;
+                        for (int64_t j = 0; j < n_atoms; j++) {
+                            int64_t lower, upper;
+                            scalar_t b;
+                            support_indices(r[i] + nt[i] * gamma * z[j], v_min, v_max, dz, n_atoms, &lower, &upper, &b);
+                            out_row[j] = g_row[lower] * (upper - b) + g_row[upper] * (b - lower);
+                        }
+                    }
+                });
+            });
+
+            return grad;
+        }
+
+        using ProjectionSignature = torch::Tensor(const torch::Tensor&, const torch::Tensor&, const torch::Tensor&, const torch::Tensor&, double);
+
+        torch::Tensor projection_op(
+            const torch::Tensor &next_distribution,
+            const torch::Tensor &rewards,
+            const torch::Tensor &not_terminals,
+            const torch::Tensor &atoms,
+            double discount
+        )
+        {
+            static auto op = c10::Dispatcher::singleton()
+                .findSchemaOrThrow("rl::categorical_projection", "")
+                .typed<ProjectionSignature>();
+            return op.call(next_distribution, rewards, not_terminals, atoms, discount);
+        }
+
+        torch::Tensor projection_backward_op(
+            const torch::Tensor &grad_output,
+            const torch::Tensor &rewards,
+            const torch::Tensor &not_terminals,
+            const torch::Tensor &atoms,
+            double discount
+        )
+        {
+            static auto op = c10::Dispatcher::singleton()
+                .findSchemaOrThrow("rl::categorical_projection_backward", "")
+                .typed<ProjectionSignature>();
+            return op.call(grad_output, rewards, not_terminals, atoms, discount);
+        }
+
+        class CategoricalProjection : public torch::autograd::Function<CategoricalProjection>
+        {
+            public:
+                static
+                torch::Tensor forward(
+                    torch::autograd::AutogradContext *ctx,
+                    const torch::Tensor &next_distribution,
+                    const torch::Tensor &rewards,
+                    const torch::Tensor &not_terminals,
+                    const torch::Tensor &atoms,
+                    double discount
+                )
+                {
+                    ctx->save_for_backward({rewards, not_terminals, atoms});
+                    ctx->saved_data["discount"] = discount;
+                    return projection_op(next_distribution, rewards, not_terminals, atoms, discount);
+                }
+
+                static
+                torch::autograd::variable_list backward(
+                    torch::autograd::AutogradContext *ctx,
+                    torch::autograd::variable_list grad_outputs
+                )
+                {
+                    auto saved = ctx->get_saved_variables();
+                    auto grad = projection_backward_op(
+                        grad_outputs[0],
+                        saved[0],
+                        saved[1],
+                        saved[2],
+                        ctx->saved_data["discount"].toDouble()
+                    );
+                    return {grad, torch::Tensor{}, torch::Tensor{}, torch::Tensor{}, torch::Tensor{}};
+                }
+        };
+    }
+
+    torch::Tensor categorical_projection(
+        const torch::Tensor &next_distribution,
+        const torch::Tensor &rewards,
+        const torch::Tensor &not_terminals,
+        const torch::Tensor &atoms,
+        float discount
+    )
+    {
+        return CategoricalProjection::apply(next_distribution, rewards, not_terminals, atoms, static_cast<double>(discount));
+    }
+}
+
+TORCH_LIBRARY(rl, m)
+{
+    m.def("categorical_projection(Tensor next_distribution, Tensor rewards, Tensor not_terminals, Tensor atoms, float discount) -> Tensor");
+    m.def("categorical_projection_backward(Tensor grad_output, Tensor rewards, Tensor not_terminals, Tensor atoms, float discount) -> Tensor");
+}
+
+TORCH_LIBRARY_IMPL(rl, CPU, m)
+{
+    m.impl("categorical_projection", &rl::agents::utils::categorical_projection_cpu);
+    m.impl("categorical_projection_backward", &rl::agents::utils::categorical_projection_backward_cpu);
+}
@@ -1,5 +1,7 @@
 #include "rl/agents/utils/distributional_loss.h"
 
+#include "rl/agents/utils/categorical_projection.h"
+
 
 using namespace torch::indexing;
 
@@ -84,8 +86,15 @@ namespace rl::agents::utils
         bool allow_cuda_graph
     )
     {
+        auto next_distribution = next_logits.softmax(-1);
+        auto log_distribution = torch::log_softmax(current_logits, -1);
+
+        if (next_distribution.device().is_cpu()) {
+            auto m = categorical_projection(next_distribution, rewards, not_terminals, atoms, discount);
+            return - (m * log_distribution).sum(-1);
+        }
+
         auto batchsize = current_logits.size(0);
-        auto batchvec = torch::arange(batchsize, torch::TensorOptions{}.device(current_logits.device()));
         auto n_atoms = atoms.size(0);
         auto dz = atoms.index({1}) - atoms.index({0});
         auto v_min = atoms.index({0});
@@ -106,12 +115,9 @@ namespace rl::agents::utils
         auto upper_mask = (lower < n_atoms - 1).logical_and_(lower_eq_upper);
         upper = torch::where(upper_mask, upper + 1, upper);
 
-        auto next_distribution = next_logits.softmax(-1);
-        
         auto get_m_fn = allow_cuda_graph ? get_m_cuda_graph_accum : get_m_torch_vectorization;
         auto m = get_m_fn(batchsize, n_atoms, next_distribution, lower, upper, b);
 
-        auto log_distribution = torch::log_softmax(current_logits, -1);
         return - (m * log_distribution).sum(-1);
     }
 }
@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include <memory>
 #include <vector>
+#include <limits>
 
 #include <rl/torchutils/torchutils.h>
 #include "rl/policies/constraints/categorical_mask.h"
@@ -30,16 +31,15 @@ namespace rl::policies
         probabilities,
         torch::arange(probabilities.size(-1), torch::TensorOptions{}.device(probabilities.device())).expand_as(probabilities)
     }
-    {}
+    {
+        values_are_indices = true;
+    }
 
     void Categorical::compute_internals()
     {
         probabilities = probabilities / probabilities.sum(-1, true);
         probabilities = probabilities.view({-1, dim});
         values = values.view_as(probabilities);
-
-        cumsummed = probabilities.cumsum(1);
-        batchvec = torch::arange(probabilities.size(0), torch::TensorOptions{}.device(probabilities.device()));
     }
 
     void Categorical::include(std::shared_ptr<constraints::Base> constraint)
@@ -48,7 +48,7 @@ namespace rl::policies
 
         if (categorical_mask) {
             auto mask = categorical_mask->mask().view_as(probabilities);
-            probabilities.index_put_({~mask}, 0.0);
+            probabilities = probabilities.masked_fill(~mask, 0.0);
             compute_internals();
             return;
         }
@@ -63,17 +63,16 @@ namespace rl::policies
 
     torch::Tensor Categorical::sample() const
     {
-        auto actions = (torch::rand(sample_shape, cumsummed.options()).unsqueeze_(1) > cumsummed).sum(1);
-        actions.clamp_max_(dim - 1);
-        auto out = values.index({batchvec, actions});
-        return out.view(sample_shape);
+        // Exponential race, equivalent to Gumbel-max: argmax of p_i / E_i, E_i ~ Exp(1).
+        auto noise = torch::empty_like(probabilities).exponential_().clamp_min_(std::numeric_limits<float>::min());
+        auto actions = (probabilities / noise).argmax(1, true);
+        if (values_are_indices) return actions.view(sample_shape);
+        return values.gather(1, actions).view(sample_shape);
     }
 
     torch::Tensor Categorical::entropy() const
     {
-        auto logged = probabilities.log();
-        logged.index_put_({logged.isinf()}, 0.0);
-        return - (probabilities * logged).sum(-1).view(sample_shape);
+        return - torch::xlogy(probabilities, probabilities).sum(-1).view(sample_shape);
     }
 
     torch::Tensor Categorical::log_prob(const torch::Tensor &value) const
@@ -83,10 +82,10 @@ namespace rl::policies
 
     torch::Tensor Categorical::prob(const torch::Tensor &value_) const
     {
-        auto value = value_.view({-1, 1});
-        auto i = torch::where(value == values);
-        assert (i.size() == 2);
-
-        return probabilities.index({i[0], i[1]}).view_as(value_);
+        auto value = value_.reshape({-1, 1});
+        if (values_are_indices) {
+            return probabilities.gather(1, value.to(torch::kLong)).view(value_.sizes());
+        }
+        return (probabilities * (values == value)).sum(1).view(value_.sizes());
     }
 }
\ No newline at end of file
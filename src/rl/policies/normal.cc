@@ -1,5 +1,7 @@
 #include "rl/policies/normal.h"
 
+#include <limits>
+
 #include "rl/policies/constraints/constraints.h"
 
 #define M_1_SQRT_2PI 0.3989422804f  // 1 / sqrt(2pi)
@@ -26,15 +28,26 @@ namespace rl::policies
 
     torch::Tensor Normal::sample() const
     {
-        auto out = torch::randn_like(mean) * std + mean;
-        auto invalid_mask = (out < lower_bound).logical_or_(out > upper_bound);
-
-        while (invalid_mask.any().item().toBool()) {
-            out.index_put_({invalid_mask}, torch::randn({invalid_mask.sum().item().toLong()}, out.options()) * std + mean);
-            invalid_mask = (out < lower_bound).logical_or_(out > upper_bound);
+        if (!truncated) {
+            return torch::randn_like(cdf_lower_bound) * std + mean;
         }
 
-        return out;
+        // Inverse transform sampling, u ~ U(F(a), F(b)) and x = F^-1(u). In float,
+        // F rounds to one in the upper tail, hence bounds above the mean are mirrored
+        // and -x is sampled from [-b, -a] instead. F(x) = erfc(-x / sqrt(2)) / 2 keeps
+        // its resolution for negative x. u is kept in the open interval (0, 1), and
+        // the sample within the bounds, in case of round-off.
+        auto a = standardize(lower_bound);
+        auto b = standardize(upper_bound);
+        auto mirror = a > 0;
+        auto cdf_lower = 0.5 * torch::erfc(-M_SQRT1_2 * torch::where(mirror, -b, a));
+        auto cdf_upper = 0.5 * torch::erfc(-M_SQRT1_2 * torch::where(mirror, -a, b));
+
+        auto u = torch::rand_like(cdf_lower) * (cdf_upper - cdf_lower) + cdf_lower;
+        u.clamp_(std::numeric_limits<float>::min(), 1 - std::numeric_limits<float>::epsilon());
+        auto z = torch::special::ndtri(u);
+        auto out = torch::where(mirror, -z, z) * std + mean;
+        return torch::max(torch::min(out, upper_bound), lower_bound);
     }
 
     torch::Tensor Normal::entropy() const
@@ -65,6 +78,7 @@ namespace rl::policies
             lower_bound.index_put_({Slice(None, None)}, torch::max(lower_bound, box->lower_bound()));
             upper_bound.index_put_({Slice(None, None)}, torch::min(upper_bound, box->upper_bound()));
             compute_cdf_at_bounds();
+            truncated = true;
             return;
         }
 
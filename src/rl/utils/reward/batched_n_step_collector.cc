@@ -0,0 +1,109 @@
+#include "rl/utils/reward/batched_n_step_collector.h"
+
+#include <rl/cpputils/concat_vector.h>
+
+
+using namespace torch::indexing;
+
+namespace rl::utils::reward
+{
+    static
+    torch::Tensor ring(int n, const torch::Tensor &x)
+    {
+        return torch::zeros(
+            rl::cpputils::concat(std::vector<int64_t>{n}, x.sizes().vec()),
+            x.options()
+        );
+    }
+
+    BatchedNStepCollector::BatchedNStepCollector(int n, float discount, int64_t batchsize)
+    : n{n}, discount{discount}, batchsize{batchsize}
+    {}
+
+    void BatchedNStepCollector::allocate(
+        const std::vector<torch::Tensor> &states,
+        const torch::Tensor &actions,
+        const torch::Tensor &rewards
+    )
+    {
+        state_ring.reserve(states.size());
+        for (const auto &state : states) {
+            state_ring.push_back(ring(n, state));
+        }
+        action_ring = ring(n, actions);
+        reward_ring = ring(n, rewards);
+        age_ring = torch::zeros({n, batchsize}, rewards.options().dtype(torch::kLong));
+        valid_ring = torch::zeros({n, batchsize}, rewards.options().dtype(torch::kBool));
+        discounts = torch::pow(
+            torch::full({n}, discount, rewards.options()),
+            torch::arange(n, rewards.options())
+        );
+    }
+
+    BatchedNStepCollectorTransitions BatchedNStepCollector::step(
+        const std::vector<torch::Tensor> &states,
+        const torch::Tensor &actions,
+        const torch::Tensor &rewards,
+        const torch::Tensor &terminals
+    )
+    {
+        if (!action_ring.defined()) {
+            allocate(states, actions, rewards);
+        }
+
+        std::vector<std::vector<torch::Tensor>> state_parts(states.size()), next_state_parts(states.size());
+        std::vector<torch::Tensor> action_parts{}, reward_parts{}, terminal_parts{};
+
+        // Slots written n steps ago are complete, with the incoming states as next
+        // states.
+        auto completed = valid_ring.index({pointer});
+        for (int i = 0; i < states.size(); i++) {
+            state_parts[i].push_back(state_ring[i].index({pointer}).index({completed}));
+            next_state_parts[i].push_back(states[i].index({completed}));
+        }
+        action_parts.push_back(action_ring.index({pointer}).index({completed}));
+        reward_parts.push_back(reward_ring.index({pointer}).index({completed}));
+        terminal_parts.push_back(torch::zeros_like(reward_parts.back(), terminals.options()));
+
+        for (int i = 0; i < states.size(); i++) {
+            state_ring[i].index_put_({pointer}, states[i]);
+        }
+        action_ring.index_put_({pointer}, actions);
+        reward_ring.index_put_({pointer}, 0.0f);
+        age_ring.index_put_({pointer}, 0);
+        valid_ring.index_put_({pointer}, true);
+
+        reward_ring.add_(
+            valid_ring * discounts.index({age_ring.clamp_max(n - 1)}) * rewards.unsqueeze(0)
+        );
+        age_ring.add_(valid_ring.to(torch::kLong));
+
+        // All pending slots of terminated environments are flushed.
+        auto flushed = valid_ring.logical_and(terminals.unsqueeze(0));
+        for (int i = 0; i < states.size(); i++) {
+            state_parts[i].push_back(state_ring[i].index({flushed}));
+            next_state_parts[i].push_back(
+                states[i].unsqueeze(0).expand_as(state_ring[i]).index({flushed})
+            );
+        }
+        action_parts.push_back(action_ring.index({flushed}));
+        reward_parts.push_back(reward_ring.index({flushed}));
+        terminal_parts.push_back(torch::ones_like(reward_parts.back(), terminals.options()));
+        valid_ring.logical_and_(terminals.logical_not().unsqueeze(0));
+
+        pointer = (pointer + 1) % n;
+
+        BatchedNStepCollectorTransitions out{};
+        out.states.reserve(states.size());
+        out.next_states.reserve(states.size());
+        for (int i = 0; i < states.size(); i++) {
+            out.states.push_back(torch::cat(state_parts[i]));
+            out.next_states.push_back(torch::cat(next_state_parts[i]));
+        }
+        out.actions = torch::cat(action_parts);
+        out.rewards = torch::cat(reward_parts);
+        out.terminals = torch::cat(terminal_parts);
+
+        return out;
+    }
+}
@@ -0,0 +1,279 @@
+#include "rl/utils/reward/discounted_scan.h"
+
+#include <algorithm>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <torch/library.h>
+
+
+using namespace torch::indexing;
+
+namespace rl::utils::reward
+{
+    namespace
+    {
+        // Kernels operate on time major copies of the inputs, i.e. of shape (H, N),
+        // such that each time step is contiguous across the batch dimension. Batch
+        // chunks are processed in parallel with plain scalar loops over contiguous
+        // rows, no explicit SIMD code is used.
+
+        // Flattens all leading dimensions into one batch dimension, (N, H).
+        torch::Tensor flatten_batch(const torch::Tensor &x)
+        {
+            return x.reshape({-1, x.size(-1)});
+        }
+
+        int64_t grain_size(int64_t history)
+        {
+            return std::max<int64_t>(1, at::internal::GRAIN_SIZE / std::max<int64_t>(history, 1));
+        }
+
+        torch::Tensor discounted_cumsum_cpu(
+            const torch::Tensor &values,
+            const torch::Tensor &not_terminals,
+            double discount
+        )
+        {
+            TORCH_CHECK(values.dim() == 2, "discounted_cumsum expects values of shape (N, H).");
+            TORCH_CHECK(not_terminals.sizes() == values.sizes(), "discounted_cumsum expects not_terminals of same shape as values.");
+
+            auto v = values.t().contiguous();
+            auto nt = not_terminals.t().to(v.scalar_type()).contiguous();
+            auto out = torch::empty_like(v);
+            auto history = v.size(0);
+            auto batchsize = v.size(1);
+            if (history == 0) return out.t();
+
+            AT_DISPATCH_FLOATING_TYPES(v.scalar_type(), "discounted_cumsum_cpu", [&] {
+                auto v_ptr = v.data_ptr<scalar_t>();
+                auto nt_ptr = nt.data_ptr<scalar_t>();
+                auto out_ptr = out.data_ptr<scalar_t>();
+                auto gamma = static_cast<scalar_t>(discount);
+
+                at::parallel_for(0, batchsize, grain_size(history), [&] (int64_t begin, int64_t end) {
+                    auto last = (history - 1) * batchsize;
+                    std::copy(v_ptr + last + begin, v_ptr + last + end, out_ptr + last + begin);
+
+                    for (int64_t t = history - 2; t >= 0; t--) {
+                        auto v_row = v_ptr + t * batchsize;
+                        auto nt_row = nt_ptr + t * batchsize;
+                        auto out_row = out_ptr + t * batchsize;
+                        auto next_row = out_row + batchsize;
+
+                        for (int64_t b = begin; b < end; b++) {
+                            out_row[b] = v_row[b] + gamma * nt_row[b] * next_row[b];
+                        }
+                    }
+                });
+            });
+
+            return out.t().contiguous();
+        }
+
+        torch::Tensor n_step_returns_cpu(
+            const torch::Tensor &rewards,
+            const torch::Tensor &values,
+            const torch::Tensor &not_terminals,
+            double discount,
+            int64_t n
+        )
+        {
+            TORCH_CHECK(rewards.dim() == 2, "n_step_returns expects rewards of shape (N, H).");
+            TORCH_CHECK(not_terminals.sizes() == rewards.sizes(), "n_step_returns expects not_terminals of same shape as rewards.");
+            TORCH_CHECK(
+                values.dim() == 2 && values.size(0) == rewards.size(0) && values.size(1) == rewards.size(1) + 1,
+                "n_step_returns expects values of shape (N, H + 1)."
+            );
+            TORCH_CHECK(n > 0, "n_step_returns expects n > 0.");
+
+            auto r = rewards.t().contiguous();
+            auto v = values.t().to(r.scalar_type()).contiguous();
+            auto nt = not_terminals.t().to(r.scalar_type()).contiguous();
+            auto out = torch::empty_like(r);
+            auto history = r.size(0);
+            auto batchsize = r.size(1);
+
+            AT_DISPATCH_FLOATING_TYPES(r.scalar_type(), "n_step_returns_cpu", [&] {
+                auto r_ptr = r.data_ptr<scalar_t>();
+                auto v_ptr = v.data_ptr<scalar_t>();
+                auto nt_ptr = nt.data_ptr<scalar_t>();
+                auto out_ptr = out.data_ptr<scalar_t>();
+                auto gamma = static_cast<scalar_t>(discount);
+
+                at::parallel_for(0, batchsize, grain_size(history * n), [&] (int64_t begin, int64_t end) {
+                    for (int64_t t = 0; t < history; t++) {
+                        auto m = std::min(n, history - t);
+                        auto out_row = out_ptr + t * batchsize;
+                        auto bootstrap_row = v_ptr + (t + m) * batchsize;
+
+                        for (int64_t b = begin; b < end; b++) {
+                            scalar_t acc = 0;
+                            scalar_t coef = 1;
+                            for (int64_t k = 0; k < m; k++) {
+                                acc += coef * r_ptr[(t + k) * batchsize + b];
+                                coef *= gamma * nt_ptr[(t + k) * batchsize + b];
+                            }
+                            out_row[b] = acc + coef * bootstrap_row[b];
+                        }
+                    }
+                });
+            });
+
+            return out.t().contiguous();
+        }
+
+        torch::Tensor discounted_cumsum_reference(
+            const torch::Tensor &values,
+            const torch::Tensor &not_terminals,
+            float discount
+        )
+        {
+            auto out = torch::empty_like(values);
+            auto history = values.size(1);
+
+            out.index_put_({Slice(), -1}, values.index({Slice(), -1}));
+            for (int64_t t = history - 2; t >= 0; t--) {
+                out.index_put_(
+                    {Slice(), t},
+                    values.index({Slice(), t}) + discount * not_terminals.index({Slice(), t}) * out.index({Slice(), t + 1})
+                );
+            }
+
+            return out;
+        }
+
+        torch::Tensor n_step_returns_reference(
+            const torch::Tensor &rewards,
+            const torch::Tensor &values,
+            const torch::Tensor &not_terminals,
+            float discount,
+            int64_t n
+        )
+        {
+            auto out = torch::empty_like(rewards);
+            auto history = rewards.size(1);
+
+            for (int64_t t = 0; t < history; t++) {
+                auto m = std::min(n, history - t);
+                auto acc = torch::zeros_like(rewards.index({Slice(), t}));
+                auto coef = torch::ones_like(acc);
+                for (int64_t k = 0; k < m; k++) {
+                    acc = acc + coef * rewards.index({Slice(), t + k});
+                    coef = coef * discount * not_terminals.index({Slice(), t + k});
+                }
+                out.index_put_({Slice(), t}, acc + coef * values.index({Slice(), t + m}));
+            }
+
+            return out;
+        }
+
+        bool use_kernel(std::initializer_list<torch::Tensor> tensors)
+        {
+            for (const auto &x : tensors) {
+                if (!x.device().is_cpu()) return false;
+                if (torch::GradMode::is_enabled() && x.requires_grad()) return false;
+            }
+            return true;
+        }
+    }
+
+    torch::Tensor discounted_cumsum(
+        const torch::Tensor &values,
+        const torch::Tensor &not_terminals,
+        float discount
+    )
+    {
+        auto v = flatten_batch(values);
+        auto nt = flatten_batch(not_terminals.expand_as(values));
+        if (!use_kernel({values, not_terminals})) {
+            return discounted_cumsum_reference(v, nt, discount).reshape(values.sizes());
+        }
+
+        static auto op = c10::Dispatcher::singleton()
+            .findSchemaOrThrow("rl::discounted_cumsum", "")
+            .typed<torch::Tensor(const torch::Tensor&, const torch::Tensor&, double)>();
+        return op.call(v, nt, static_cast<double>(discount)).reshape(values.sizes());
+    }
+
+    torch::Tensor discounted_cumsum(const torch::Tensor &values, float discount)
+    {
+        return discounted_cumsum(values, torch::ones_like(values), discount);
+    }
+
+    torch::Tensor generalized_advantages(
+        const torch::Tensor &rewards,
+        const torch::Tensor &values,
+        const torch::Tensor &not_terminals,
+        float discount,
+        float gae_discount
+    )
+    {
+        auto deltas = rewards + discount * not_terminals * values.index({"...", Slice(1, None)}) - values.index({"...", Slice(None, -1)});
+        return discounted_cumsum(deltas, not_terminals, discount * gae_discount);
+    }
+
+    VTrace vtrace(
+        const torch::Tensor &rewards,
+        const torch::Tensor &values,
+        const torch::Tensor &not_terminals,
+        const torch::Tensor &behavior_probabilities,
+        const torch::Tensor &target_probabilities,
+        float discount,
+        float trace_discount,
+        float rho_max,
+        float c_max
+    )
+    {
+        torch::NoGradGuard no_grad{};
+
+        auto ratios = target_probabilities / behavior_probabilities;
+        auto rhos = ratios.clamp_max(rho_max);
+        auto cs = trace_discount * ratios.clamp_max(c_max);
+
+        auto V_current = values.index({"...", Slice(None, -1)});
+        auto V_next = values.index({"...", Slice(1, None)});
+
+        // v_t - V_t = rho_t * delta_t + discount * c_t * (v_{t+1} - V_{t+1})
+        auto deltas = rhos * (rewards + discount * not_terminals * V_next - V_current);
+        auto value_targets = V_current + discounted_cumsum(deltas, not_terminals * cs, discount);
+
+        auto next_targets = torch::cat({value_targets.index({"...", Slice(1, None)}), values.index({"...", Slice(-1, None)})}, -1);
+        auto advantages = rewards + discount * not_terminals * next_targets - V_current;
+
+        return {value_targets, advantages, rhos * advantages};
+    }
+
+    torch::Tensor n_step_returns(
+        const torch::Tensor &rewards,
+        const torch::Tensor &values,
+        const torch::Tensor &not_terminals,
+        float discount,
+        int64_t n
+    )
+    {
+        auto r = flatten_batch(rewards);
+        auto v = flatten_batch(values);
+        auto nt = flatten_batch(not_terminals.expand_as(rewards));
+        if (!use_kernel({rewards, values, not_terminals})) {
+            return n_step_returns_reference(r, v, nt, discount, n).reshape(rewards.sizes());
+        }
+
+        static auto op = c10::Dispatcher::singleton()
+            .findSchemaOrThrow("rl::n_step_returns", "")
+            .typed<torch::Tensor(const torch::Tensor&, const torch::Tensor&, const torch::Tensor&, double, int64_t)>();
+        return op.call(r, v, nt, static_cast<double>(discount), n).reshape(rewards.sizes());
+    }
+}
+
+TORCH_LIBRARY_FRAGMENT(rl, m)
+{
+    m.def("discounted_cumsum(Tensor values, Tensor not_terminals, float discount) -> Tensor");
+    m.def("n_step_returns(Tensor rewards, Tensor values, Tensor not_terminals, float discount, int n) -> Tensor");
+}
+
+TORCH_LIBRARY_IMPL(rl, CPU, m)
+{
+    m.impl("discounted_cumsum", &rl::utils::reward::discounted_cumsum_cpu);
+    m.impl("n_step_returns", &rl::utils::reward::n_step_returns_cpu);
+}
@@ -0,0 +1,79 @@
+#include <torch/torch.h>
+#include <gtest/gtest.h>
+
+#include <rl/agents/alpha_zero/alpha_zero.h>
+
+
+using namespace rl::agents::alpha_zero;
+
+
+TEST(evaluation_cache, forwards_misses_only)
+{
+    EvaluationCache cache{EvaluationCacheOptions{}.max_size_(10)};
+    int64_t evaluated{0};
+
+    auto inference_fn = [&] (const torch::Tensor &states) {
+        evaluated += states.size(0);
+        return MCTSInferenceResult{
+            torch::ones({states.size(0), 3}),
+            states.index({torch::indexing::Slice(), 0}).to(torch::kFloat32)
+        };
+    };
+
+    auto states = torch::arange(8).view({4, 2});
+    auto output = cache.evaluate(states, inference_fn, torch::kCPU);
+    ASSERT_EQ(evaluated, 4);
+    ASSERT_EQ(cache.size(), 4);
+
+    output = cache.evaluate(states.index({torch::indexing::Slice(1, 3)}), inference_fn, torch::kCPU);
+    ASSERT_EQ(evaluated, 4);
+    ASSERT_TRUE(output.values.equal(torch::tensor({2.0f, 4.0f})));
+
+    cache.publish_version();
+    ASSERT_EQ(cache.size(), 0);
+    cache.evaluate(states, inference_fn, torch::kCPU);
+    ASSERT_EQ(evaluated, 8);
+}
+
+TEST(evaluation_cache, evicts_least_recently_used)
+{
+    EvaluationCache cache{EvaluationCacheOptions{}.max_size_(2)};
+    int64_t evaluated{0};
+
+    auto inference_fn = [&] (const torch::Tensor &states) {
+        evaluated += states.size(0);
+        return MCTSInferenceResult{torch::ones({states.size(0), 3}), torch::zeros({states.size(0)})};
+    };
+
+    cache.evaluate(torch::tensor({{0}, {1}}), inference_fn, torch::kCPU);
+    cache.evaluate(torch::tensor({{0}}), inference_fn, torch::kCPU);
+    cache.evaluate(torch::tensor({{2}}), inference_fn, torch::kCPU);
+    ASSERT_EQ(evaluated, 3);
+    ASSERT_EQ(cache.size(), 2);
+
+    cache.evaluate(torch::tensor({{0}}), inference_fn, torch::kCPU);
+    ASSERT_EQ(evaluated, 3);
+    cache.evaluate(torch::tensor({{1}}), inference_fn, torch::kCPU);
+    ASSERT_EQ(evaluated, 4);
+}
+
+TEST(evaluation_cache, keys_include_dtype_and_shape)
+{
+    EvaluationCache cache{EvaluationCacheOptions{}.max_size_(10)};
+    int64_t evaluated{0};
+
+    auto inference_fn = [&] (const torch::Tensor &states) {
+        evaluated += states.size(0);
+        return MCTSInferenceResult{torch::ones({states.size(0), 3}), torch::zeros({states.size(0)})};
+    };
+
+    cache.evaluate(torch::zeros({1, 4}, torch::kInt32), inference_fn, torch::kCPU);
+    ASSERT_EQ(evaluated, 1);
+    cache.evaluate(torch::zeros({1, 4}, torch::kFloat32), inference_fn, torch::kCPU);
+    ASSERT_EQ(evaluated, 2);
+    cache.evaluate(torch::zeros({1, 2, 2}, torch::kInt32), inference_fn, torch::kCPU);
+    ASSERT_EQ(evaluated, 3);
+    cache.evaluate(torch::zeros({1, 4}, torch::kInt32), inference_fn, torch::kCPU);
+    ASSERT_EQ(evaluated, 3);
+    ASSERT_EQ(cache.size(), 3);
+}
@@ -0,0 +1,87 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <torch/torch.h>
+#include <gtest/gtest.h>
+
+#include <agents/alpha_zero/trainer_impl/gradient_reducer.h>
+
+
+namespace
+{
+    class CountingSGD : public torch::optim::SGD
+    {
+        public:
+            CountingSGD(std::vector<torch::Tensor> parameters)
+            : torch::optim::SGD{parameters, torch::optim::SGDOptions{1.0}}
+            {}
+
+            torch::Tensor step(LossClosure closure=nullptr) override
+            {
+                steps++;
+                return torch::optim::SGD::step(closure);
+            }
+
+            std::atomic<int> steps{0};
+    };
+}
+
+TEST(gradient_reducer, averages_one_step_per_generation)
+{
+    int workers{3}, generations{4};
+    auto weight = torch::zeros({1}, torch::requires_grad());
+    auto optimizer = std::make_shared<CountingSGD>(std::vector<torch::Tensor>{weight});
+    int on_step_calls{0};
+    trainer_impl::GradientReducer reducer{
+        optimizer, std::make_shared<std::mutex>(), workers, [&] () { on_step_calls++; }
+    };
+
+    std::vector<std::vector<torch::Tensor>> norms(workers);
+    std::vector<std::thread> threads{};
+    for (int i = 0; i < workers; i++) {
+        threads.emplace_back([&, i] () {
+            for (int g = 0; g < generations; g++) {
+                // Gradients 1, 2 and 3, averaging to 2.
+                (weight * (i + 1.0f)).sum().backward();
+                norms[i].push_back(reducer.reduce_and_step());
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+
+    ASSERT_EQ(optimizer->steps.load(), generations);
+    ASSERT_EQ(on_step_calls, generations);
+    ASSERT_NEAR(weight.item().toFloat(), -2.0f * generations, 1e-5);
+    for (const auto &worker_norms : norms) {
+        ASSERT_EQ(worker_norms.size(), static_cast<size_t>(generations));
+        for (const auto &norm : worker_norms) {
+            ASSERT_TRUE(norm.defined());
+            ASSERT_NEAR(norm.item().toFloat(), 2.0f, 1e-5);
+        }
+    }
+}
+
+TEST(gradient_reducer, stop_releases_waiting_workers)
+{
+    auto weight = torch::zeros({1}, torch::requires_grad());
+    auto optimizer = std::make_shared<CountingSGD>(std::vector<torch::Tensor>{weight});
+    trainer_impl::GradientReducer reducer{optimizer, std::make_shared<std::mutex>(), 2};
+
+    torch::Tensor norm = torch::ones({});
+    std::thread thread{[&] () {
+        weight.sum().backward();
+        norm = reducer.reduce_and_step();
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    reducer.stop();
+    thread.join();
+
+    ASSERT_FALSE(norm.defined());
+    ASSERT_EQ(optimizer->steps.load(), 0);
+    ASSERT_FALSE(reducer.reduce_and_step().defined());
+}
@@ -0,0 +1,143 @@
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <torch/torch.h>
+#include <gtest/gtest.h>
+
+#include <agents/alpha_zero/trainer_impl/inference_server.h>
+
+
+namespace
+{
+    class EchoOutput : public modules::BaseOutput
+    {
+        public:
+            EchoOutput(const torch::Tensor &values)
+            : BaseOutput{torch::zeros({values.size(0), 2})}, values{values}
+            {}
+
+            torch::Tensor value_estimates() const override { return values; }
+
+            torch::Tensor value_loss(const torch::Tensor &rewards) const override {
+                return torch::tensor(0.0f);
+            }
+
+        private:
+            torch::Tensor values;
+    };
+
+    // Returns each state as its value, and records the size of every executed batch.
+    class EchoModule : public modules::Base
+    {
+        public:
+            EchoModule(bool fail=false) : fail{fail} {}
+
+            std::unique_ptr<modules::BaseOutput> forward(const torch::Tensor &states) override
+            {
+                {
+                    std::lock_guard lock{mtx};
+                    batchsizes.push_back(states.size(0));
+                }
+                if (fail) {
+                    throw std::runtime_error{"Inference failed."};
+                }
+                return std::make_unique<EchoOutput>(states.view({-1}));
+            }
+
+            std::vector<int64_t> get_batchsizes()
+            {
+                std::lock_guard lock{mtx};
+                return batchsizes;
+            }
+
+        private:
+            bool fail;
+            std::mutex mtx{};
+            std::vector<int64_t> batchsizes{};
+    };
+
+    trainer_impl::InferenceServerOptions server_options(int max_batchsize, int max_delay_ms)
+    {
+        return trainer_impl::InferenceServerOptions{}
+            .max_batchsize_(max_batchsize)
+            .max_delay_ms_(max_delay_ms)
+            .enable_cuda_graph_inference_(false);
+    }
+}
+
+TEST(inference_server, merges_concurrent_requests)
+{
+    auto module = std::make_shared<EchoModule>();
+    trainer_impl::InferenceServer server{module, server_options(8, 1000)};
+    server.start();
+
+    std::vector<torch::Tensor> values(4);
+    std::vector<std::thread> threads{};
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&, i] () {
+            auto states = torch::tensor({2.0f * i, 2.0f * i + 1}).unsqueeze(1);
+            values[i] = server.infer(states).values;
+        });
+    }
+    for (auto &thread : threads) thread.join();
+    server.stop();
+
+    ASSERT_EQ(module->get_batchsizes(), std::vector<int64_t>{8});
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(torch::equal(values[i], torch::tensor({2.0f * i, 2.0f * i + 1})));
+    }
+}
+
+TEST(inference_server, flushes_partial_batch_at_deadline)
+{
+    auto module = std::make_shared<EchoModule>();
+    trainer_impl::InferenceServer server{module, server_options(8, 20)};
+    server.start();
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = server.infer(torch::tensor({1.0f, 2.0f, 3.0f}).unsqueeze(1));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    server.stop();
+
+    ASSERT_GE(elapsed, std::chrono::milliseconds(20));
+    ASSERT_EQ(module->get_batchsizes(), std::vector<int64_t>{3});
+    ASSERT_TRUE(torch::equal(result.values, torch::tensor({1.0f, 2.0f, 3.0f})));
+}
+
+TEST(inference_server, propagates_exceptions_to_all_requesters)
+{
+    auto module = std::make_shared<EchoModule>(true);
+    trainer_impl::InferenceServer server{module, server_options(6, 1000)};
+    server.start();
+
+    std::vector<uint8_t> failed(3, 0);
+    std::vector<std::thread> threads{};
+    for (int i = 0; i < 3; i++) {
+        threads.emplace_back([&, i] () {
+            try {
+                server.infer(torch::zeros({2, 1}));
+            } catch (const std::runtime_error &) {
+                failed[i] = 1;
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+    server.stop();
+
+    ASSERT_EQ(module->get_batchsizes(), std::vector<int64_t>{6});
+    ASSERT_EQ(failed, std::vector<uint8_t>(3, 1));
+}
+
+TEST(inference_server, rejects_oversized_requests)
+{
+    auto module = std::make_shared<EchoModule>();
+    trainer_impl::InferenceServer server{module, server_options(8, 5)};
+    server.start();
+
+    ASSERT_THROW(server.infer(torch::zeros({9, 1})), std::invalid_argument);
+    server.stop();
+
+    ASSERT_TRUE(module->get_batchsizes().empty());
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <torch/torch.h>
 #include <gtest/gtest.h>
 
@@ -69,3 +71,282 @@ TEST(mcts, single_step)
         ASSERT_EQ(visit_count.argmax().item().toLong(), 0);
     }
 }
+
+TEST(mcts, pipelined)
+{
+    int sims{200};
+    int n{5};
+
+    auto module = std::make_shared<Module>(5);
+    auto sim = std::make_shared<rl::simulators::CombinatorialLock>(5, std::vector{0, 1, 2, 3, 4});
+
+    auto states = sim->reset(n);
+    auto masks = std::dynamic_pointer_cast<rl::policies::constraints::CategoricalMask>(states.action_constraints);
+    auto options = MCTSOptions{}.steps_(sims).dirchlet_noise_epsilon_(0.0f);
+
+    auto serial_nodes = mcts(states.states, masks, module, sim, options);
+    auto nodes = mcts(states.states, masks, module, sim, MCTSOptions{options}.pipeline_groups_(2));
+
+    // Without noise the search is deterministic, and pipelining only changes
+    // the order in which disjoint trees are expanded.
+    for (int i = 0; i < n; i++) {
+        auto visit_count = nodes[i]->visit_count();
+        ASSERT_EQ(visit_count.sum().item().toLong(), sims);
+        ASSERT_TRUE(visit_count.equal(serial_nodes[i]->visit_count()));
+    }
+}
+
+TEST(mcts, sparse_children)
+{
+    int sims{100};
+    int n{5};
+
+    auto module = std::make_shared<Module>(5);
+    auto sim = std::make_shared<rl::simulators::CombinatorialLock>(5, std::vector{0, 1, 2, 3, 4});
+
+    auto states = sim->reset(n);
+    auto nodes = mcts(
+        states.states,
+        std::dynamic_pointer_cast<rl::policies::constraints::CategoricalMask>(states.action_constraints),
+        module,
+        sim,
+        MCTSOptions{}
+            .steps_(sims)
+            .max_children_(3)
+    );
+
+    for (const auto &node : nodes) {
+        ASSERT_TRUE(node->is_sparse());
+        auto visit_count = node->visit_count();
+        ASSERT_EQ(visit_count.size(0), 5);
+        ASSERT_EQ(visit_count.sum().item().toLong(), sims);
+        ASSERT_LE((visit_count > 0).sum().item().toLong(), 3);
+    }
+}
+
+TEST(mcts, gumbel)
+{
+    int sims{16};
+    int n{5};
+
+    auto module = std::make_shared<Module>(5);
+    auto sim = std::make_shared<rl::simulators::CombinatorialLock>(5, std::vector{0, 1, 2, 3, 4});
+
+    auto states = sim->reset(n);
+    auto nodes = mcts(
+        states.states,
+        std::dynamic_pointer_cast<rl::policies::constraints::CategoricalMask>(states.action_constraints),
+        module,
+        sim,
+        MCTSOptions{}
+            .steps_(sims)
+            .gumbel_(true)
+            .gumbel_max_considered_actions_(4)
+    );
+
+    for (const auto &node : nodes) {
+        auto visit_count = node->visit_count();
+        ASSERT_EQ(visit_count.sum().item().toLong(), sims);
+        ASSERT_EQ((visit_count > 0).sum().item().toLong(), 4);
+
+        auto improved_policy = node->improved_policy();
+        ASSERT_TRUE(improved_policy.defined());
+        ASSERT_NEAR(improved_policy.sum().item().toFloat(), 1.0f, 1e-5f);
+
+        auto action = node->selected_action();
+        ASSERT_GE(action, 0);
+        ASSERT_TRUE(node->get_child(action));
+        ASSERT_EQ(visit_count.index({action}).item().toLong(), visit_count.max().item().toLong());
+    }
+}
+
+TEST(mcts, adaptive)
+{
+    int sims{100};
+    int n{5};
+
+    auto module = std::make_shared<Module>(5);
+    auto sim = std::make_shared<rl::simulators::CombinatorialLock>(5, std::vector{0, 1, 2, 3, 4});
+
+    auto states = sim->reset(n);
+    auto nodes = mcts(
+        states.states,
+        std::dynamic_pointer_cast<rl::policies::constraints::CategoricalMask>(states.action_constraints),
+        module,
+        sim,
+        MCTSOptions{}
+            .steps_(sims)
+            .adaptive_check_period_(10)
+            .adaptive_kl_threshold_(0.01f)
+    );
+
+    int64_t total{0};
+    for (const auto &node : nodes) {
+        auto visits = node->visit_count().sum().item().toLong();
+        // Convergence is tested first at the second checkpoint.
+        ASSERT_GE(visits, 20);
+        ASSERT_LE(visits, 2 * sims);
+        total += visits;
+    }
+    ASSERT_LE(total, sims * n);
+}
+
+// Prior peaked on action zero for states whose first element is zero, and
+// uniform otherwise.
+class PeakedModule : public modules::Base
+{
+    public:
+        PeakedModule(int64_t dim) : dim{dim} {}
+
+        std::unique_ptr<modules::BaseOutput> forward(const torch::Tensor &states) override {
+            auto logits = torch::zeros({states.size(0), dim});
+            logits.index_put_({states.select(1, 0) == 0, 0}, 10.0f);
+            return std::make_unique<ModuleOutput>(torch::zeros({states.size(0)}), logits);
+        }
+
+    private:
+        int64_t dim;
+};
+
+TEST(mcts, adaptive_converging_root)
+{
+    int sims{100};
+    int n{3};
+
+    auto module = std::make_shared<PeakedModule>(5);
+    auto sim = std::make_shared<rl::simulators::CombinatorialLock>(5, std::vector{0, 1, 2, 3, 4});
+
+    // The first root starts with action zero, and hence has a peaked prior. The
+    // other roots start with action one, and search uniformly over all actions.
+    auto states = sim->reset(n);
+    states.states.index_put_({torch::indexing::Slice(), 0}, 1);
+    states.states.index_put_({0, 0}, 0);
+
+    auto nodes = mcts(
+        states.states,
+        std::dynamic_pointer_cast<rl::policies::constraints::CategoricalMask>(states.action_constraints),
+        module,
+        sim,
+        MCTSOptions{}
+            .steps_(sims)
+            .dirchlet_noise_epsilon_(0.0f)
+            .adaptive_check_period_(10)
+            .adaptive_margin_threshold_(0.5f)
+    );
+
+    // The peaked root converges at the second checkpoint, while visits of the
+    // uniform roots stay balanced and never reach the margin.
+    auto converged_visits = nodes[0]->visit_count().sum().item().toLong();
+    ASSERT_LT(converged_visits, sims);
+
+    int64_t total{converged_visits};
+    for (int i = 1; i < n; i++) {
+        auto visits = nodes[i]->visit_count().sum().item().toLong();
+        ASSERT_GT(visits, sims);
+        total += visits;
+    }
+    ASSERT_LE(total, sims * n);
+}
+
+TEST(mcts, expand_all_children)
+{
+    int sims{1000};
+    int n{5};
+
+    auto module = std::make_shared<Module>(5);
+    auto sim = std::make_shared<rl::simulators::CombinatorialLock>(5, std::vector{0, 1, 2, 3, 4});
+
+    auto states = sim->reset(n);
+    auto nodes = mcts(
+        states.states,
+        std::dynamic_pointer_cast<rl::policies::constraints::CategoricalMask>(states.action_constraints),
+        module,
+        sim,
+        MCTSOptions{}
+            .steps_(sims)
+            .dirchlet_noise_epsilon_(0.0f)
+            .expand_all_children_(true)
+    );
+
+    for (const auto &node : nodes) {
+        auto visit_count = node->visit_count();
+        ASSERT_EQ(visit_count.sum().item().toLong(), sims);
+        ASSERT_EQ(visit_count.argmax().item().toLong(), 0);
+        ASSERT_TRUE(node->unexpanded_actions().empty());
+    }
+}
+
+TEST(mcts, incompatible_modes)
+{
+    auto module = std::make_shared<Module>(5);
+    auto sim = std::make_shared<rl::simulators::CombinatorialLock>(5, std::vector{0, 1, 2, 3, 4});
+    auto states = sim->reset(2);
+    auto masks = std::dynamic_pointer_cast<rl::policies::constraints::CategoricalMask>(states.action_constraints);
+
+    ASSERT_THROW(
+        mcts(states.states, masks, module, sim, MCTSOptions{}.gumbel_(true).pipeline_groups_(2)),
+        std::invalid_argument
+    );
+    ASSERT_THROW(
+        mcts(states.states, masks, module, sim, MCTSOptions{}.adaptive_check_period_(10).expand_all_children_(true)),
+        std::invalid_argument
+    );
+    ASSERT_NO_THROW(validate_mcts_options(MCTSOptions{}.expand_all_children_(true)));
+}
+
+class CountingSimulator : public rl::simulators::Base
+{
+    public:
+        CountingSimulator(std::shared_ptr<rl::simulators::Base> simulator) : simulator{simulator} {}
+
+        rl::simulators::States reset(int64_t n) const override { return simulator->reset(n); }
+
+        rl::simulators::Observations step(const torch::Tensor &states, const torch::Tensor &actions) const override {
+            calls++;
+            return simulator->step(states, actions);
+        }
+
+        mutable int64_t calls{0};
+
+    private:
+        std::shared_ptr<rl::simulators::Base> simulator;
+};
+
+TEST(mcts, expand_all_children_calls)
+{
+    int sims{50};
+    int n{1};
+
+    auto lock = std::make_shared<rl::simulators::CombinatorialLock>(5, std::vector{0, 1, 2, 3, 4});
+    auto states = lock->reset(n);
+    auto masks = std::dynamic_pointer_cast<rl::policies::constraints::CategoricalMask>(states.action_constraints);
+
+    auto run = [&] (bool expand_all_children, int64_t *sim_calls, int64_t *inference_calls, int64_t *max_evaluated) {
+        auto sim = std::make_shared<CountingSimulator>(lock);
+        auto inference_fn = [&] (const torch::Tensor &x) {
+            (*inference_calls)++;
+            *max_evaluated = std::max(*max_evaluated, x.size(0));
+            return MCTSInferenceResult{torch::ones({x.size(0), 5}) / 5, torch::zeros({x.size(0)})};
+        };
+        mcts(states.states, masks, inference_fn, sim, MCTSOptions{}.steps_(sims).dirchlet_noise_epsilon_(0.0f).expand_all_children_(expand_all_children));
+        *sim_calls = sim->calls;
+    };
+
+    int64_t serial_sim_calls{0}, serial_inference_calls{0}, serial_max_evaluated{0};
+    run(false, &serial_sim_calls, &serial_inference_calls, &serial_max_evaluated);
+    int64_t sim_calls{0}, inference_calls{0}, max_evaluated{0};
+    run(true, &sim_calls, &inference_calls, &max_evaluated);
+
+    // Serial search makes one simulator and one inference call per simulation,
+    // plus the root evaluation.
+    ASSERT_EQ(serial_sim_calls, sims);
+    ASSERT_EQ(serial_inference_calls, sims + 1);
+    ASSERT_EQ(serial_max_evaluated, n);
+
+    // Expanding all children makes one simulator and one inference call per
+    // expansion step, each covering all children of the expanded nodes, and later
+    // simulations through pre-populated children make no calls at all.
+    ASSERT_EQ(max_evaluated, 5 * n);
+    ASSERT_EQ(inference_calls, sim_calls + 1);
+    ASSERT_LT(sim_calls, serial_sim_calls);
+}
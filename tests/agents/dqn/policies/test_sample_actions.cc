@@ -0,0 +1,65 @@
+#include "torch_test.h"
+
+#include <torch/torch.h>
+#include <gtest/gtest.h>
+#include <rl/agents/dqn/policies/policies.h>
+
+
+using namespace rl::agents::dqn::policies;
+
+
+void check_valid_actions(Base &policy, torch::Device device)
+{
+    auto values = torch::randn({512, 8}).to(device);
+    auto masks = (torch::rand({512, 8}) > 0.5).to(device);
+    masks.index_put_({torch::indexing::Slice(), 0}, true);
+
+    auto actions = policy.sample_actions(values, masks);
+    ASSERT_EQ(actions.size(0), 512);
+
+    auto batchvec = torch::arange(512, actions.options());
+    ASSERT_TRUE(masks.index({batchvec, actions}).all().item().toBool());
+}
+
+
+TORCH_TEST(dqn_policies, sample_actions_valid, device)
+{
+    EpsilonGreedy epsilon_greedy{0.5f};
+    ValueSoftmax value_softmax{1.0f};
+    Uniform uniform{};
+    Greedy greedy{};
+    Hierarchical hierarchical{
+        {std::make_shared<EpsilonGreedy>(0.1f), std::make_shared<ValueSoftmax>(0.5f)},
+        std::vector<float>{0.5f, 0.5f}
+    };
+
+    check_valid_actions(epsilon_greedy, device);
+    check_valid_actions(value_softmax, device);
+    check_valid_actions(uniform, device);
+    check_valid_actions(greedy, device);
+    check_valid_actions(hierarchical, device);
+}
+
+
+TORCH_TEST(dqn_policies, sample_actions_greedy, device)
+{
+    EpsilonGreedy policy{0.0f};
+    auto values = torch::randn({512, 8}).to(device);
+    auto masks = torch::ones({512, 8}, torch::kBool).to(device);
+
+    auto actions = policy.sample_actions(values, masks);
+    ASSERT_TRUE(actions.equal(values.argmax(-1)));
+}
+
+
+TORCH_TEST(dqn_policies, sample_actions_softmax_frequencies, device)
+{
+    ValueSoftmax policy{1.0f};
+    auto values = torch::tensor({0.0f, 1.0f, 2.0f}).to(device).unsqueeze(0).repeat({20000, 1});
+    auto masks = torch::ones({20000, 3}, torch::kBool).to(device);
+
+    auto actions = policy.sample_actions(values, masks);
+    auto frequencies = torch::bincount(actions.cpu(), {}, 3).to(torch::kFloat32) / 20000.0f;
+    auto expected = torch::softmax(torch::tensor({0.0f, 1.0f, 2.0f}), -1);
+    ASSERT_TRUE(frequencies.allclose(expected, 0.0, 0.02));
+}
@@ -0,0 +1,46 @@
+#include <torch/torch.h>
+#include <gtest/gtest.h>
+#include <rl/agents/dqn/utils/hindsight_replay.h>
+#include <rl/policies/constraints/categorical_mask.h>
+
+
+using namespace rl::agents::dqn::utils;
+
+
+TEST(dqn_utils, episode_to_n_step_transitions)
+{
+    HindsightReplayEpisode episode{};
+    for (int i = 0; i < 6; i++) {
+        auto state = std::make_shared<rl::env::State>();
+        state->state = torch::tensor(i);
+        state->action_constraint = std::make_shared<rl::policies::constraints::CategoricalMask>(
+            torch::ones({2}, torch::kBool)
+        );
+        episode.states.push_back(state);
+
+        if (i < 5) {
+            episode.actions.push_back(torch::tensor(10 + i));
+            episode.rewards.push_back(10.0f * i);
+        }
+    }
+
+    auto transitions = episode_to_n_step_transitions(episode, 3, 0.75f);
+    ASSERT_EQ(transitions.rewards.size(0), 5);
+
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(transitions.states[0].index({i}).item().toLong(), i);
+        ASSERT_EQ(transitions.actions.index({i}).item().toLong(), 10 + i);
+
+        auto expected_reward = 0.0f;
+        for (int k = 0; k < 3 && i + k < 5; k++) {
+            expected_reward += std::pow(0.75f, k) * 10.0f * (i + k);
+        }
+        ASSERT_NEAR(transitions.rewards.index({i}).item().toFloat(), expected_reward, 1e-3);
+
+        auto terminal = i + 3 > 4;
+        ASSERT_EQ(transitions.terminals.index({i}).item().toBool(), terminal);
+        if (!terminal) {
+            ASSERT_EQ(transitions.next_states[0].index({i}).item().toLong(), i + 3);
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#include <torch/torch.h>
+#include <gtest/gtest.h>
+#include <rl/rl.h>
+#include <rl/agents/ppo/trainers/basic_rollouts.h>
+
+
+using namespace rl;
+using namespace rl::agents::ppo::trainers;
+using namespace torch::indexing;
+
+
+class RolloutTestModule : public agents::ppo::Module
+{
+    public:
+        RolloutTestModule(int64_t state_size, int64_t dim)
+        : dim{dim}
+        {
+            linear = register_module("linear", torch::nn::Linear{state_size, dim + 1});
+        }
+
+        std::unique_ptr<agents::ppo::ModuleOutput> forward(const torch::Tensor &input) override
+        {
+            auto out = linear->forward(input.to(torch::kFloat32));
+            auto re = std::make_unique<agents::ppo::ModuleOutput>();
+            re->policy = std::make_unique<policies::Categorical>(
+                out.index({"...", Slice(None, dim)}).softmax(-1)
+            );
+            re->value = out.index({"...", dim});
+            return re;
+        }
+
+    private:
+        int64_t dim;
+        torch::nn::Linear linear{nullptr};
+};
+
+static
+std::vector<std::shared_ptr<env::Base>> combinatorial_lock_envs(int n)
+{
+    auto sim = std::make_shared<simulators::CombinatorialLock>(4, std::vector<int>{1, 2, 3});
+    std::vector<std::shared_ptr<env::Base>> envs{};
+    for (int i = 0; i < n; i++) {
+        envs.push_back(std::make_shared<env::SimWrapper>(sim));
+        envs.back()->reset();
+    }
+    return envs;
+}
+
+static
+void assert_sequences_shape(const CompiledSequences &sequences, int64_t n, int64_t length)
+{
+    ASSERT_EQ(sequences.states.sizes(), torch::IntArrayRef({n, length + 1, 3}));
+    ASSERT_EQ(sequences.actions.sizes(), torch::IntArrayRef({n, length}));
+    ASSERT_EQ(sequences.rewards.sizes(), torch::IntArrayRef({n, length}));
+    ASSERT_EQ(sequences.not_terminals.sizes(), torch::IntArrayRef({n, length}));
+    ASSERT_EQ(sequences.action_probabilities.sizes(), torch::IntArrayRef({n, length}));
+    ASSERT_EQ(sequences.state_values.sizes(), torch::IntArrayRef({n, length}));
+
+    auto mask = std::dynamic_pointer_cast<policies::constraints::CategoricalMask>(sequences.constraints);
+    ASSERT_TRUE(mask);
+    ASSERT_EQ(mask->mask().sizes(), torch::IntArrayRef({n, length, 4}));
+    ASSERT_TRUE(sequences.constraints->contains(sequences.actions).all().item().toBool());
+}
+
+TEST(ppo_basic_rollouts, lockstep_matches_per_env_shapes)
+{
+    auto model = std::make_shared<RolloutTestModule>(3, 4);
+    auto options = BasicOptions{}.sequence_length_(7);
+    thread_pool pool{2};
+
+    auto sequences = run_sequences(combinatorial_lock_envs(3), model, options, pool);
+    auto lockstep_sequences = run_lockstep_sequences(combinatorial_lock_envs(3), model, options, pool);
+
+    assert_sequences_shape(*sequences, 3, 7);
+    assert_sequences_shape(*lockstep_sequences, 3, 7);
+    ASSERT_EQ(sequences->not_terminals.sum().item().toLong(), lockstep_sequences->not_terminals.sum().item().toLong());
+
+    auto policy = model->forward(lockstep_sequences->states.index({Slice(), Slice(None, -1)}))->policy;
+    ASSERT_NO_THROW(policy->include(lockstep_sequences->constraints));
+}
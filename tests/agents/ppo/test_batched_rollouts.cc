@@ -0,0 +1,103 @@
+#include <torch/torch.h>
+#include <gtest/gtest.h>
+#include <rl/rl.h>
+#include <rl/agents/ppo/trainers/batched_rollouts.h>
+
+
+using namespace rl;
+using namespace rl::agents::ppo::trainers;
+using namespace torch::indexing;
+
+
+namespace
+{
+    class BatchedRolloutTestModule : public agents::ppo::Module
+    {
+        public:
+            BatchedRolloutTestModule(int64_t state_size, int64_t dim)
+            : dim{dim}
+            {
+                linear = register_module("linear", torch::nn::Linear{state_size, dim + 1});
+            }
+
+            std::unique_ptr<agents::ppo::ModuleOutput> forward(const torch::Tensor &input) override
+            {
+                auto out = linear->forward(input.to(torch::kFloat32));
+                auto re = std::make_unique<agents::ppo::ModuleOutput>();
+                re->policy = std::make_unique<policies::Categorical>(
+                    out.index({"...", Slice(None, dim)}).softmax(-1)
+                );
+                re->value = out.index({"...", dim});
+                return re;
+            }
+
+        private:
+            int64_t dim;
+            torch::nn::Linear linear{nullptr};
+    };
+
+    // Combinatorial lock in which initial states only allow action zero, and all
+    // other states disallow it. Hence, sampled actions reveal which constraints
+    // they were sampled from.
+    class RestrictedLock : public simulators::Base
+    {
+        public:
+            simulators::States reset(int64_t n) const override
+            {
+                auto out = lock.reset(n);
+                auto mask = torch::zeros({n, 4}, torch::kBool);
+                mask.index_put_({Slice(), 0}, true);
+                out.action_constraints = std::make_shared<policies::constraints::CategoricalMask>(mask);
+                return out;
+            }
+
+            simulators::Observations step(const torch::Tensor &states, const torch::Tensor &actions) const override
+            {
+                auto out = lock.step(states, actions);
+                auto mask = torch::ones({states.size(0), 4}, torch::kBool);
+                mask.index_put_({Slice(), 0}, false);
+                out.next_states.action_constraints = std::make_shared<policies::constraints::CategoricalMask>(mask);
+                return out;
+            }
+
+        private:
+            simulators::CombinatorialLock lock{4, {0, 1, 2}};
+    };
+}
+
+TEST(ppo_batched_rollouts, combinatorial_lock)
+{
+    int64_t n = 5, length = 7;
+    auto model = std::make_shared<BatchedRolloutTestModule>(3, 4);
+    auto simulator = std::make_shared<RestrictedLock>();
+    auto states = simulator->reset(n);
+
+    auto sequences = run_batched_sequences(&states, model, simulator, BatchedOptions{}.sequence_length_(length));
+
+    ASSERT_EQ(sequences->states.sizes(), torch::IntArrayRef({n, length + 1, 3}));
+    ASSERT_EQ(sequences->actions.sizes(), torch::IntArrayRef({n, length}));
+    ASSERT_EQ(sequences->rewards.sizes(), torch::IntArrayRef({n, length}));
+    ASSERT_EQ(sequences->not_terminals.sizes(), torch::IntArrayRef({n, length}));
+    ASSERT_EQ(sequences->action_probabilities.sizes(), torch::IntArrayRef({n, length}));
+    ASSERT_EQ(sequences->state_values.sizes(), torch::IntArrayRef({n, length}));
+    ASSERT_TRUE(torch::equal(states.states, sequences->states.select(1, length)));
+
+    // Episodes terminate after three steps, at t = 2 and t = 5.
+    auto terminals = sequences->not_terminals.logical_not();
+    ASSERT_TRUE((terminals.sum(1) == 2).all().item().toBool());
+
+    // Terminal rows are replaced by initial states, all others are not.
+    auto next_states = sequences->states.index({Slice(), Slice(1, None)});
+    ASSERT_TRUE((next_states.index({terminals}) == -1).all().item().toBool());
+    ASSERT_TRUE((next_states.index({sequences->not_terminals}) >= 0).any(-1).all().item().toBool());
+
+    // Merged constraints hold the initial state constraints exactly for reset rows.
+    auto mask = std::dynamic_pointer_cast<policies::constraints::CategoricalMask>(sequences->constraints);
+    ASSERT_TRUE(mask);
+    ASSERT_EQ(mask->mask().sizes(), torch::IntArrayRef({n, length, 4}));
+    ASSERT_TRUE(sequences->constraints->contains(sequences->actions).all().item().toBool());
+
+    auto is_start = (sequences->states.index({Slice(), Slice(None, -1)}) == -1).all(-1);
+    ASSERT_TRUE((sequences->actions.index({is_start}) == 0).all().item().toBool());
+    ASSERT_TRUE((sequences->actions.index({is_start.logical_not()}) != 0).all().item().toBool());
+}
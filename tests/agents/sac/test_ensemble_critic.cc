@@ -0,0 +1,42 @@
+#include <torch/torch.h>
+#include <gtest/gtest.h>
+#include <rl/agents/sac/ensemble_critic.h>
+
+
+using namespace rl::agents::sac;
+
+
+TEST(sac_ensemble_critic, matches_members)
+{
+    MLPEnsembleCritic critic{5, MLPEnsembleCriticOptions{}.ensemble_size_(3).hidden_sizes_({8})};
+    auto params = critic.named_parameters();
+
+    auto states = torch::randn({7, 2, 2});
+    auto actions = torch::randn({7});
+    auto values = critic.forward(states, actions).value();
+    ASSERT_EQ(values.sizes(), torch::IntArrayRef({3, 7}));
+
+    auto x = torch::cat({states.flatten(1), actions.unsqueeze(1)}, 1);
+    for (int e = 0; e < 3; e++) {
+        auto h = torch::relu(x.matmul(params["weight0"][e]) + params["bias0"][e]);
+        auto expected = (h.matmul(params["weight1"][e]) + params["bias1"][e]).squeeze(-1);
+        ASSERT_TRUE(values[e].allclose(expected, 1e-5, 1e-5));
+    }
+}
+
+TEST(sac_ensemble_critic, clone)
+{
+    MLPEnsembleCritic critic{3, MLPEnsembleCriticOptions{}.ensemble_size_(4)};
+    auto copy = critic.clone();
+
+    auto states = torch::randn({6, 2});
+    auto actions = torch::randn({6, 1});
+    ASSERT_TRUE(critic.forward(states, actions).value().equal(copy->forward(states, actions).value()));
+    ASSERT_EQ(copy->size(), 4);
+
+    {
+        torch::NoGradGuard no_grad{};
+        for (auto &param : critic.parameters()) param.add_(1.0f);
+    }
+    ASSERT_FALSE(critic.forward(states, actions).value().equal(copy->forward(states, actions).value()));
+}
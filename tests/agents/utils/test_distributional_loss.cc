@@ -3,6 +3,7 @@
 
 #include <torch_test.h>
 #include <rl/agents/utils/distributional_loss.h>
+#include <rl/agents/utils/categorical_projection.h>
 
 
 torch::Tensor working_distributional_loss(
@@ -95,3 +96,52 @@ TORCH_TEST(distributional_loss, equal, device)
     ASSERT_TRUE(output1.allclose(output2));
     ASSERT_TRUE(output1.allclose(output3));
 }
+
+
+torch::Tensor reference_projection(
+    const torch::Tensor &next_distribution,
+    const torch::Tensor &rewards,
+    const torch::Tensor &not_terminals,
+    const torch::Tensor &atoms,
+    float discount
+)
+{
+    auto n_atoms = atoms.size(0);
+    auto dz = atoms.index({1}) - atoms.index({0});
+    auto projection = rewards.view({-1, 1}) + not_terminals.view({-1, 1}) * discount * atoms.view({1, -1});
+    projection = projection.clamp(atoms.index({0}), atoms.index({-1}));
+    auto b = (projection - atoms.index({0})) / dz;
+
+    auto lower = b.floor().to(torch::kLong).clamp_(0, n_atoms - 1);
+    auto upper = b.ceil().to(torch::kLong).clamp_(0, n_atoms - 1);
+    lower = torch::where((upper > 0).logical_and(lower == upper), lower - 1, lower);
+    upper = torch::where((lower < n_atoms - 1).logical_and(lower == upper), upper + 1, upper);
+
+    auto m = torch::zeros_like(next_distribution);
+    m = m.scatter_add(1, lower, next_distribution * (upper - b));
+    m = m.scatter_add(1, upper, next_distribution * (b - lower));
+    return m;
+}
+
+
+TEST(distributional_loss, projection_gradient)
+{
+    auto next_logits = torch::randn({256, 21});
+    auto rewards = torch::rand({256});
+    auto not_terminals = torch::rand({256}) > 0.5;
+    auto atoms = torch::linspace(-1.0f, 1.0f, 21);
+    auto weights = torch::randn({256, 21});
+
+    auto next_distribution1 = next_logits.softmax(-1).requires_grad_(true);
+    auto m1 = rl::agents::utils::categorical_projection(
+        next_distribution1, rewards, not_terminals, atoms, 0.99f
+    );
+    (m1 * weights).sum().backward();
+
+    auto next_distribution2 = next_logits.softmax(-1).requires_grad_(true);
+    auto m2 = reference_projection(next_distribution2, rewards, not_terminals, atoms, 0.99f);
+    (m2 * weights).sum().backward();
+
+    ASSERT_TRUE(m1.allclose(m2, 1e-4, 1e-5));
+    ASSERT_TRUE(next_distribution1.grad().allclose(next_distribution2.grad(), 1e-4, 1e-5));
+}
@@ -62,3 +62,40 @@ TORCH_TEST(buffers, tensor_and_object, device)
     ASSERT_EQ(sample->tensors[0].size(0), 100);
     ASSERT_EQ(sample->tensors[1].size(0), 100);
 }
+
+
+TORCH_TEST(buffers, tensor_and_object_reserve_commit, device)
+{
+    auto options1 = torch::TensorOptions{}.dtype(torch::kFloat32).device(device);
+    auto options2 = torch::TensorOptions{}.dtype(torch::kBool).device(device);
+
+    auto buffer = std::make_shared<buffers::TensorAndObject<P>>(
+        10,
+        std::vector<std::vector<int64_t>>{{3, 2}, {3}},
+        std::vector<torch::TensorOptions>{options1, options2}
+    );
+
+    auto row = buffer->reserve();
+    ASSERT_EQ(row.tensors.size(), 2);
+    ASSERT_EQ(row.tensors[0].sizes(), torch::IntArrayRef({3, 2}));
+    ASSERT_EQ(row.tensors[1].sizes(), torch::IntArrayRef({3}));
+
+    for (int t = 0; t < 3; t++) {
+        row.tensors[0].select(0, t).fill_(t);
+        row.tensors[1].select(0, t).fill_(t % 2 == 0);
+    }
+    ASSERT_EQ(buffer->size(), 0);
+
+    buffer->commit(row, P(1, 2));
+    ASSERT_EQ(buffer->size(), 1);
+
+    auto sample = buffer->get({0});
+    ASSERT_EQ(sample->objs[0].x, 1); ASSERT_EQ(sample->objs[0].y, 2);
+    ASSERT_TRUE(sample->tensors[0][0].equal(torch::arange(3, options1).unsqueeze(1).expand({3, 2})));
+    ASSERT_TRUE(sample->tensors[1][0].equal(torch::tensor({true, false, true}, options2)));
+
+    auto next_row = buffer->reserve();
+    ASSERT_EQ(next_row.id, row.id);
+    next_row.tensors[0].zero_();
+    ASSERT_TRUE(buffer->get({0})->tensors[0][0].equal(torch::arange(3, options1).unsqueeze(1).expand({3, 2})));
+}
@@ -91,3 +91,23 @@ TORCH_TEST(policies, categorical_custom_values, device)
     ASSERT_FLOAT_EQ(entropy.index({0}).item().toFloat(), 0.94334839232f);
     ASSERT_FLOAT_EQ(entropy.index({1}).item().toFloat(), 0.0);
 }
+
+TORCH_TEST(policies, categorical_sample_frequencies, device)
+{
+    auto probabilities = torch::tensor({0.1f, 0.5f, 0.0f, 0.4f}, torch::TensorOptions{}.device(device)).expand({20000, 4});
+    auto d = Categorical{probabilities};
+    d.include(std::make_shared<constraints::CategoricalMask>(
+        torch::tensor({true, true, true, false}, torch::TensorOptions{}.device(device)).expand({20000, 4})
+    ));
+
+    auto counts = torch::bincount(d.sample().cpu(), {}, 4).to(torch::kFloat32) / 20000.0f;
+    ASSERT_NEAR(counts.index({0}).item().toFloat(), 1.0f / 6.0f, 0.02f);
+    ASSERT_NEAR(counts.index({1}).item().toFloat(), 5.0f / 6.0f, 0.02f);
+    ASSERT_EQ(counts.index({2}).item().toFloat(), 0.0f);
+    ASSERT_EQ(counts.index({3}).item().toFloat(), 0.0f);
+
+    auto prob = d.prob(torch::tensor({0, 1, 3}, torch::TensorOptions{}.dtype(torch::kLong).device(device)).repeat({20000 / 3 + 1}).slice(0, 0, 20000));
+    ASSERT_NEAR(prob.index({0}).item().toFloat(), 1.0f / 6.0f, 1e-5);
+    ASSERT_NEAR(prob.index({1}).item().toFloat(), 5.0f / 6.0f, 1e-5);
+    ASSERT_EQ(prob.index({2}).item().toFloat(), 0.0f);
+}
@@ -28,3 +28,44 @@ TORCH_TEST(test_policies, test_normal, device)
         auto sample = d.sample();
     }
 }
+
+TORCH_TEST(test_policies, test_normal_truncated_sample, device)
+{
+    auto mean = torch::zeros({10000}).to(device);
+    Normal d{mean, torch::tensor(1.0).to(device)};
+
+    auto box = std::make_shared<constraints::Box>(
+        torch::full({10000}, 2.0f).to(device),
+        torch::full({10000}, 3.0f).to(device)
+    );
+    d.include(box);
+
+    auto sample = d.sample().cpu();
+    ASSERT_EQ(sample.sizes(), torch::IntArrayRef({10000}));
+    ASSERT_TRUE(sample.ge(2.0f).all().item().toBool());
+    ASSERT_TRUE(sample.le(3.0f).all().item().toBool());
+
+    // Mean of a standard normal truncated to [2, 3].
+    ASSERT_NEAR(sample.mean().item().toFloat(), 2.3158f, 0.02f);
+}
+
+TORCH_TEST(test_policies, test_normal_truncated_sample_tail, device)
+{
+    auto mean = torch::zeros({10000}).to(device);
+    Normal d{mean, torch::tensor(1.0).to(device)};
+
+    // F(5) rounds to one in float, the upper tail must still be sampled.
+    auto box = std::make_shared<constraints::Box>(
+        torch::full({10000}, 5.0f).to(device),
+        torch::full({10000}, 6.0f).to(device)
+    );
+    d.include(box);
+
+    auto sample = d.sample().cpu();
+    ASSERT_TRUE(sample.ge(5.0f).all().item().toBool());
+    ASSERT_TRUE(sample.le(6.0f).all().item().toBool());
+    ASSERT_GT(sample.gt(5.0f).sum().item().toLong(), 9900);
+
+    // Mean of a standard normal truncated to [5, 6].
+    ASSERT_NEAR(sample.mean().item().toFloat(), 5.1831f, 0.01f);
+}
@@ -26,3 +26,58 @@ TORCH_TEST(gradient_norm, gradient_norm, device)
 
     ASSERT_FLOAT_EQ(rl::torchutils::compute_gradient_norm(optimizer).item().toFloat(), std::sqrt(32.0 * 32.0 + 48.0 * 48.0));
 }
+
+
+TORCH_TEST(gradient_norm, clip_gradient_norm, device)
+{
+    auto w = torch::tensor({1.0, 2.0}, torch::TensorOptions{}.device(device));
+    auto v = torch::tensor({3.0}, torch::TensorOptions{}.device(device));
+    w.set_requires_grad(true);
+    v.set_requires_grad(true);
+
+    auto optimizer = std::make_shared<torch::optim::SGD>(
+        std::vector{w, v},
+        torch::optim::SGDOptions{1.0}
+    );
+
+    auto x = torch::tensor({2.0, 3.0}, torch::TensorOptions{}.device(device));
+
+    auto loss = (w * x).sum().square() + v.sum();
+    loss.backward();
+
+    auto norm = std::sqrt(32.0 * 32.0 + 48.0 * 48.0 + 1.0);
+    ASSERT_NEAR(rl::torchutils::clip_gradient_norm(optimizer, 1000.0f).item().toFloat(), norm, 1e-3);
+    ASSERT_FLOAT_EQ(w.grad().index({0}).item().toFloat(), 32.0f);
+
+    ASSERT_NEAR(rl::torchutils::clip_gradient_norm(optimizer, 1.0f).item().toFloat(), norm, 1e-3);
+    ASSERT_NEAR(rl::torchutils::compute_gradient_norm(optimizer).item().toFloat(), 1.0f, 1e-4);
+    ASSERT_NEAR(v.grad().index({0}).item().toFloat(), 1.0f / norm, 1e-4);
+}
+
+
+TORCH_TEST(gradient_norm, clip_ensemble_gradient_norm, device)
+{
+    auto w = torch::zeros({2, 2}, torch::TensorOptions{}.device(device));
+    auto b = torch::zeros({2, 1}, torch::TensorOptions{}.device(device));
+    w.set_requires_grad(true);
+    b.set_requires_grad(true);
+
+    auto optimizer = std::make_shared<torch::optim::SGD>(
+        std::vector{w, b},
+        torch::optim::SGDOptions{1.0}
+    );
+
+    // Member gradients ((3, 4), 0) and ((0.3, 0.4), 0), of norms 5 and 0.5.
+    auto w_gradient = torch::tensor({3.0f, 4.0f, 0.3f, 0.4f}, torch::TensorOptions{}.device(device)).view({2, 2});
+    auto loss = (w * w_gradient).sum() + b.sum() * 0.0f;
+    loss.backward();
+
+    auto norms = rl::torchutils::clip_ensemble_gradient_norm(optimizer, 1.0f).cpu();
+    ASSERT_EQ(norms.sizes(), torch::IntArrayRef({2}));
+    ASSERT_NEAR(norms.index({0}).item().toFloat(), 5.0f, 1e-4);
+    ASSERT_NEAR(norms.index({1}).item().toFloat(), 0.5f, 1e-4);
+
+    // Only the first member exceeds the maximum norm.
+    auto expected = torch::tensor({0.6f, 0.8f, 0.3f, 0.4f}, torch::TensorOptions{}.device(device)).view({2, 2});
+    ASSERT_TRUE(w.grad().allclose(expected, 1e-4, 1e-4));
+}
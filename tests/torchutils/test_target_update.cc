@@ -0,0 +1,35 @@
+#include <torch_test.h>
+#include <rl/torchutils/target_update.h>
+#include <torch/torch.h>
+
+
+TORCH_TEST(target_update, polyak_update, device)
+{
+    std::vector<torch::Tensor> targets{
+        torch::zeros({2}, torch::TensorOptions{}.device(device)),
+        torch::ones({3}, torch::TensorOptions{}.device(device))
+    };
+    std::vector<torch::Tensor> sources{
+        torch::ones({2}, torch::TensorOptions{}.device(device)),
+        torch::full({3}, 3.0f, torch::TensorOptions{}.device(device))
+    };
+
+    rl::torchutils::polyak_update(targets, sources, 0.25f);
+
+    ASSERT_TRUE(targets[0].allclose(torch::full({2}, 0.25f, torch::TensorOptions{}.device(device))));
+    ASSERT_TRUE(targets[1].allclose(torch::full({3}, 1.5f, torch::TensorOptions{}.device(device))));
+}
+
+TORCH_TEST(target_update, hard_update, device)
+{
+    std::vector<torch::Tensor> targets{
+        torch::zeros({2}, torch::TensorOptions{}.device(device))
+    };
+    std::vector<torch::Tensor> sources{
+        torch::randn({2}, torch::TensorOptions{}.device(device))
+    };
+
+    rl::torchutils::hard_update(targets, sources);
+
+    ASSERT_TRUE(targets[0].equal(sources[0]));
+}
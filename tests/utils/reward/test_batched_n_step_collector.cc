@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <unordered_set>
+
+#include <gtest/gtest.h>
+
+#include <rl/utils/reward/batched_n_step_collector.h>
+
+
+auto batched_step(
+    rl::utils::reward::BatchedNStepCollector *collector,
+    int i,
+    const std::vector<bool> &terminal
+)
+{
+    auto batchsize = static_cast<int64_t>(terminal.size());
+    auto states = torch::full({batchsize}, i, torch::kLong);
+    auto actions = torch::full({batchsize}, 10 + i, torch::kLong);
+    auto rewards = torch::full({batchsize}, 10.0f * i);
+    auto terminals = torch::zeros({batchsize}, torch::kBool);
+    for (int j = 0; j < batchsize; j++) {
+        terminals.index_put_({j}, static_cast<bool>(terminal[j]));
+    }
+
+    return collector->step({states}, actions, rewards, terminals);
+}
+
+
+TEST(batched_n_step_collector, loop)
+{
+    rl::utils::reward::BatchedNStepCollector collector{3, 0.75, 2};
+
+    for (int i = 0; i < 3; i++)
+    {
+        auto out = batched_step(&collector, i, {false, false});
+        ASSERT_EQ(out.rewards.size(0), 0);
+    }
+
+    for (int i = 3; i < 100; i++)
+    {
+        auto out = batched_step(&collector, i, {false, false});
+        ASSERT_EQ(out.rewards.size(0), 2);
+
+        for (int j = 0; j < 2; j++) {
+            ASSERT_EQ(out.states[0].index({j}).item().toLong(), i - 3);
+            ASSERT_EQ(out.actions.index({j}).item().toLong(), 7 + i);
+            ASSERT_NEAR(
+                out.rewards.index({j}).item().toFloat(),
+                10.0f * ( (i-3) + 0.75 * (i-2) + 0.75 * 0.75 * (i-1) ),
+                1e-3
+            );
+            ASSERT_FALSE(out.terminals.index({j}).item().toBool());
+            ASSERT_EQ(out.next_states[0].index({j}).item().toLong(), i);
+        }
+    }
+}
+
+
+TEST(batched_n_step_collector, loop_terminal)
+{
+    rl::utils::reward::BatchedNStepCollector collector{3, 0.75, 2};
+
+    for (int i = 0; i < 10; i++) {
+        batched_step(&collector, i, {false, false});
+    }
+
+    // Only the first environment terminates.
+    auto out = batched_step(&collector, 10, {true, false});
+    ASSERT_EQ(out.rewards.size(0), 5);
+
+    std::unordered_set<float> rewards {
+        10.0f * ( 8 + 0.75 * 9 + 0.75 * 0.75 * 10),
+        10.0f * ( 9 + 0.75 * 10),
+        10.0f * ( 10 )
+    };
+    auto n_terminals = out.terminals.sum().item().toLong();
+    ASSERT_EQ(n_terminals, 3);
+
+    for (int i = 0; i < 5; i++) {
+        if (!out.terminals.index({i}).item().toBool()) {
+            ASSERT_EQ(out.states[0].index({i}).item().toLong(), 7);
+            continue;
+        }
+
+        auto reward = out.rewards.index({i}).item().toFloat();
+        auto match = std::find_if(
+            rewards.begin(), rewards.end(),
+            [reward] (float x) { return std::abs(x - reward) < 1e-3; }
+        );
+        ASSERT_TRUE(match != rewards.end());
+        rewards.erase(match);
+    }
+
+    // The first environment restarts, the second continues.
+    for (int i = 0; i < 3; i++)
+    {
+        auto out = batched_step(&collector, 11 + i, {false, false});
+        ASSERT_EQ(out.rewards.size(0), 1);
+        ASSERT_EQ(out.states[0].index({0}).item().toLong(), 8 + i);
+    }
+
+    out = batched_step(&collector, 14, {false, false});
+    ASSERT_EQ(out.rewards.size(0), 2);
+}
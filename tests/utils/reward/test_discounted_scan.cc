@@ -0,0 +1,189 @@
+#include "torch_test.h"
+
+#include <rl/utils/reward/discounted_scan.h>
+
+
+static torch::Tensor expected_cumsum(const torch::Tensor &values, const torch::Tensor &not_terminals, float discount)
+{
+    auto v = values.cpu();
+    auto nt = not_terminals.cpu().to(torch::kFloat32);
+    auto out = torch::zeros_like(v);
+    auto v_accessor = v.accessor<float, 2>();
+    auto nt_accessor = nt.accessor<float, 2>();
+    auto out_accessor = out.accessor<float, 2>();
+
+    for (int64_t i = 0; i < v.size(0); i++) {
+        float acc = 0.0f;
+        for (int64_t t = v.size(1) - 1; t >= 0; t--) {
+            if (t < v.size(1) - 1) acc *= discount * nt_accessor[i][t];
+            acc += v_accessor[i][t];
+            out_accessor[i][t] = acc;
+        }
+    }
+    return out;
+}
+
+TORCH_TEST(discounted_scan, discounted_cumsum, device)
+{
+    auto values = torch::randn({13, 7}).to(device);
+    auto not_terminals = (torch::rand({13, 7}) > 0.2).to(device);
+
+    auto out = rl::utils::reward::discounted_cumsum(values, not_terminals, 0.9f);
+    ASSERT_TRUE(out.device().type() == device.type());
+    ASSERT_TRUE(out.cpu().allclose(expected_cumsum(values, not_terminals, 0.9f), 1e-5, 1e-5));
+
+    auto no_resets = rl::utils::reward::discounted_cumsum(values, 0.9f);
+    ASSERT_TRUE(no_resets.cpu().allclose(expected_cumsum(values, torch::ones_like(values), 0.9f), 1e-5, 1e-5));
+}
+
+TORCH_TEST(discounted_scan, leading_dimensions, device)
+{
+    auto values = torch::randn({3, 4, 7}).to(device);
+    auto not_terminals = (torch::rand({3, 4, 7}) > 0.2).to(device);
+
+    auto out = rl::utils::reward::discounted_cumsum(values, not_terminals, 0.9f);
+    ASSERT_EQ(out.sizes(), values.sizes());
+    ASSERT_TRUE(out.cpu().view({12, 7}).allclose(expected_cumsum(values.view({12, 7}), not_terminals.view({12, 7}), 0.9f), 1e-5, 1e-5));
+
+    auto single = rl::utils::reward::discounted_cumsum(values.index({0, 0}), not_terminals.index({0, 0}), 0.9f);
+    ASSERT_TRUE(single.allclose(out.index({0, 0}), 1e-5, 1e-5));
+
+    auto rewards = torch::randn({3, 4, 6}).to(device);
+    auto returns = rl::utils::reward::n_step_returns(rewards, values, not_terminals.slice(2, 0, -1), 0.9f, 2);
+    auto flat_returns = rl::utils::reward::n_step_returns(rewards.view({12, 6}), values.view({12, 7}), not_terminals.slice(2, 0, -1).reshape({12, 6}), 0.9f, 2);
+    ASSERT_TRUE(returns.view({12, 6}).allclose(flat_returns, 1e-5, 1e-5));
+}
+
+TORCH_TEST(discounted_scan, generalized_advantages, device)
+{
+    auto rewards = torch::randn({11, 5}).to(device);
+    auto values = torch::randn({11, 6}).to(device);
+    auto not_terminals = (torch::rand({11, 5}) > 0.3).to(device);
+
+    auto deltas = rewards + 0.99f * not_terminals * values.slice(1, 1) - values.slice(1, 0, -1);
+    auto expected = expected_cumsum(deltas, not_terminals, 0.99f * 0.95f);
+
+    auto advantages = rl::utils::reward::generalized_advantages(rewards, values, not_terminals, 0.99f, 0.95f);
+    ASSERT_TRUE(advantages.cpu().allclose(expected, 1e-5, 1e-5));
+}
+
+TORCH_TEST(discounted_scan, vtrace, device)
+{
+    // Terminal after the second step, and the first step has an importance
+    // ratio of two, clipped by both rho_max and c_max.
+    auto rewards = torch::tensor({{1.0f, 2.0f, 3.0f}}).to(device);
+    auto values = torch::tensor({{0.5f, 1.0f, 2.0f, 4.0f}}).to(device);
+    auto not_terminals = torch::tensor({{true, false, true}}).to(device);
+    auto behavior_probabilities = torch::tensor({{0.4f, 0.4f, 0.5f}}).to(device);
+    auto target_probabilities = torch::tensor({{0.8f, 0.2f, 0.5f}}).to(device);
+
+    auto out = rl::utils::reward::vtrace(
+        rewards, values, not_terminals, behavior_probabilities, target_probabilities,
+        0.9f, 1.0f, 1.0f, 0.8f
+    );
+
+    // rho = (1, 0.5, 1), c = (0.8, 0.5, 0.8)
+    // rho * delta = (1.4, 0.5, 4.6)
+    // v_2 = 2 + 4.6, v_1 = 1 + 0.5, v_0 = 0.5 + 1.4 + 0.9 * 0.8 * 0.5
+    ASSERT_TRUE(out.value_targets.cpu().allclose(torch::tensor({{2.26f, 1.5f, 6.6f}}), 1e-5, 1e-5));
+    // A_t = r_t + 0.9 * not_terminal_t * v_{t+1} - V_t, with v_3 = V_3
+    ASSERT_TRUE(out.advantages.cpu().allclose(torch::tensor({{1.85f, 1.0f, 4.6f}}), 1e-5, 1e-5));
+    ASSERT_TRUE(out.weighted_advantages.cpu().allclose(torch::tensor({{1.85f, 0.5f, 4.6f}}), 1e-5, 1e-5));
+}
+
+TORCH_TEST(discounted_scan, vtrace_surrogate_gradient, device)
+{
+    auto rewards = torch::randn({11, 5}).to(device);
+    auto values = torch::randn({11, 6}).to(device);
+    auto not_terminals = (torch::rand({11, 5}) > 0.3).to(device);
+    auto behavior_probabilities = (torch::rand({11, 5}) * 0.8f + 0.1f).to(device);
+    auto target_probabilities = (torch::rand({11, 5}) * 0.8f + 0.1f).to(device).requires_grad_(true);
+
+    // rho_max above all ratios, such that no importance weight is clipped.
+    auto out = rl::utils::reward::vtrace(
+        rewards, values, not_terminals, behavior_probabilities, target_probabilities,
+        0.99f, 0.95f, 10.0f, 1.0f
+    );
+
+    // The gradient of the ratio weighted surrogate equals the V-trace policy
+    // gradient, rho_t * A_t * grad log pi.
+    auto surrogate = (target_probabilities / behavior_probabilities * out.advantages).sum();
+    auto surrogate_gradient = torch::autograd::grad({surrogate}, {target_probabilities})[0];
+    auto policy_gradient = (out.weighted_advantages * target_probabilities.log()).sum();
+    auto policy_gradient_gradient = torch::autograd::grad({policy_gradient}, {target_probabilities})[0];
+
+    ASSERT_TRUE(surrogate_gradient.cpu().allclose(policy_gradient_gradient.cpu(), 1e-4, 1e-4));
+}
+
+TORCH_TEST(discounted_scan, vtrace_on_policy, device)
+{
+    auto rewards = torch::randn({11, 5}).to(device);
+    auto values = torch::randn({11, 6}).to(device);
+    auto not_terminals = (torch::rand({11, 5}) > 0.3).to(device);
+    auto probabilities = torch::rand({11, 5}).to(device) + 0.1f;
+
+    auto gae = rl::utils::reward::generalized_advantages(rewards, values, not_terminals, 0.99f, 0.95f);
+    auto out = rl::utils::reward::vtrace(rewards, values, not_terminals, probabilities, probabilities, 0.99f, 0.95f, 1.0f, 1.0f);
+    ASSERT_TRUE((out.value_targets - values.slice(1, 0, -1)).cpu().allclose(gae.cpu(), 1e-5, 1e-5));
+
+    // Without trace discount, advantages are the lambda = 1 advantages.
+    gae = rl::utils::reward::generalized_advantages(rewards, values, not_terminals, 0.99f, 1.0f);
+    out = rl::utils::reward::vtrace(rewards, values, not_terminals, probabilities, probabilities, 0.99f, 1.0f, 1.0f, 1.0f);
+    ASSERT_TRUE(out.advantages.cpu().allclose(gae.cpu(), 1e-5, 1e-5));
+    ASSERT_TRUE(out.weighted_advantages.cpu().allclose(gae.cpu(), 1e-5, 1e-5));
+}
+
+TORCH_TEST(discounted_scan, n_step_returns, device)
+{
+    auto rewards = torch::tensor({
+        {1.0f, 2.0f, 3.0f, 4.0f},
+        {1.0f, 1.0f, 1.0f, 1.0f}
+    }).to(device);
+    auto values = torch::tensor({
+        {10.0f, 20.0f, 30.0f, 40.0f, 50.0f},
+        {10.0f, 10.0f, 10.0f, 10.0f, 10.0f}
+    }).to(device);
+    auto not_terminals = torch::tensor({
+        {true, true, true, true},
+        {true, false, true, true}
+    }).to(device);
+
+    auto G = rl::utils::reward::n_step_returns(rewards, values, not_terminals, 0.5f, 2).cpu();
+    auto G_accessor = G.accessor<float, 2>();
+
+    ASSERT_FLOAT_EQ(G_accessor[0][0], 1.0f + 0.5f * 2.0f + 0.25f * 30.0f);
+    ASSERT_FLOAT_EQ(G_accessor[0][1], 2.0f + 0.5f * 3.0f + 0.25f * 40.0f);
+    ASSERT_FLOAT_EQ(G_accessor[0][2], 3.0f + 0.5f * 4.0f + 0.25f * 50.0f);
+    ASSERT_FLOAT_EQ(G_accessor[0][3], 4.0f + 0.5f * 50.0f);
+
+    ASSERT_FLOAT_EQ(G_accessor[1][0], 1.0f + 0.5f * 1.0f);
+    ASSERT_FLOAT_EQ(G_accessor[1][1], 1.0f);
+    ASSERT_FLOAT_EQ(G_accessor[1][2], 1.0f + 0.5f * 1.0f + 0.25f * 10.0f);
+    ASSERT_FLOAT_EQ(G_accessor[1][3], 1.0f + 0.5f * 10.0f);
+}
+
+TORCH_TEST(discounted_scan, gradient, device)
+{
+    auto values = torch::randn({9, 4}, torch::TensorOptions{}.device(device).requires_grad(true));
+    auto not_terminals = (torch::rand({9, 4}) > 0.2).to(device);
+
+    auto out = rl::utils::reward::discounted_cumsum(values, not_terminals, 0.8f);
+    out.sum().backward();
+
+    {
+        torch::NoGradGuard no_grad{};
+        auto out_no_grad = rl::utils::reward::discounted_cumsum(values.detach(), not_terminals, 0.8f);
+        ASSERT_TRUE(out.detach().allclose(out_no_grad, 1e-5, 1e-5));
+    }
+
+    // d/dv[t] sum(out) = sum over k <= t of prod of discounted not terminals from k to t.
+    auto grad = values.grad().cpu();
+    auto nt = not_terminals.cpu().to(torch::kFloat32);
+    for (int64_t i = 0; i < 9; i++) {
+        float acc = 0.0f;
+        for (int64_t t = 0; t < 4; t++) {
+            acc = 1.0f + (t > 0 ? 0.8f * nt[i][t - 1].item().toFloat() * acc : 0.0f);
+            ASSERT_NEAR(grad[i][t].item().toFloat(), acc, 1e-5);
+        }
+    }
+}